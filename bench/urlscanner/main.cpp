@@ -0,0 +1,97 @@
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "urlscanner.h"
+
+// the kinds of text the scanner runs over in a crawl, with a few long
+// stretches without any slash (minified code, prose)
+static const char* const CORPUS_PARTS[] = {
+    "<script>var api = \"https://api.example.com/v2/items?page=1&size=20\";\n"
+    "fetch('/api/user/profile').then(function (r) { return r.json(); });\n"
+    "require(\"./lib/util.js\"); import x from '../shared/x.mjs';</script>\n",
+    "{\"data\":[{\"id\":1,\"href\":\"/item/1\",\"img\":\"//cdn.example.com/i/1.png\"},"
+    "{\"id\":2,\"href\":\"/item/2\",\"next\":\"wss://push.example.com/socket\"}],\"total\":2}\n",
+    ".banner{background:url(/static/img/banner.jpg) no-repeat}\n"
+    "@font-face{src:url(\"../fonts/a.woff2\") format(\"woff2\")}\n",
+    "<img srcset=\"/img/a-480.jpg 480w, /img/a-800.jpg 800w\" src=\"/img/a.jpg\">\n",
+    "function a(b,c){for(var d=0;d<b.length;d++){c=c*31+b.charCodeAt(d)|0}return c}"
+    "var e=[1,2,3,4,5,6,7,8,9,10].map(function(f){return f*f}).filter(Boolean);\n",
+    "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+    "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud "
+    "exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.\n",
+    "<a href=\"ftp://files.example.com/pub/release.tar.gz\">a</a> 1/2 and a/b are no path\n",
+    0
+};
+
+static const int CORPUS_SIZE = 16 * 1024 * 1024;
+
+static QByteArray corpus()
+{
+    QByteArray text;
+    text.reserve(CORPUS_SIZE);
+    while (text.size() < CORPUS_SIZE) {
+        for (int i = 0; CORPUS_PARTS[i]; ++i) {
+            text += CORPUS_PARTS[i];
+        }
+    }
+    return text;
+}
+
+// usage: urlscanner-bench [runs] [file]
+// Times UrlScanner::scan on every instruction set this build and CPU can
+// run, best of `runs`, over a built-in 16 MB corpus or `file`. Exits 1
+// when an instruction set finds other tokens than the scalar code.
+int main(int argc, char** argv)
+{
+    int runs = argc > 1 ? qMax(1, atoi(argv[1])) : 10;
+    QByteArray text;
+    if (argc > 2) {
+        QFile file(QString::fromLocal8Bit(argv[2]));
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "Open File[%s] error: %s\n", argv[2], qPrintable(file.errorString()));
+            return 1;
+        }
+        text = file.readAll();
+    } else {
+        text = corpus();
+    }
+
+    printf("best: %s, corpus: %d bytes, runs: %d\n", UrlScanner::isa().constData(), text.size(), runs);
+
+    static const char* const isas[] = { "scalar", "sse2", "avx2", 0 };
+    QList<QByteArray> expected;
+    int result = 0;
+    for (int i = 0; isas[i]; ++i) {
+        if (!UrlScanner::setIsa(isas[i])) {
+            printf("%-8s not available\n", isas[i]);
+            continue;
+        }
+
+        QList<QByteArray> tokens = UrlScanner::scan(text);
+        qint64 best = -1;
+        for (int run = 0; run < runs; ++run) {
+            QElapsedTimer timer;
+            timer.start();
+            tokens = UrlScanner::scan(text);
+            qint64 elapsed = timer.nsecsElapsed();
+            if (best < 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+
+        if (i == 0) {
+            expected = tokens;
+        } else if (tokens != expected) {
+            result = 1;
+        }
+        printf("%-8s %10.3f ms %10.1f MB/s %10d tokens%s\n", isas[i], best / 1e6,
+               text.size() / (best / 1e9) / (1024 * 1024), tokens.size(),
+               i > 0 && tokens != expected ? "  MISMATCH" : "");
+    }
+    return result;
+}
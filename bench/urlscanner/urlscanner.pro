@@ -0,0 +1,17 @@
+# UrlScanner::scan microbenchmark, not part of the bradypod build:
+#   qmake bench/urlscanner/urlscanner.pro && make && ./urlscanner-bench
+
+QT     = core core-private
+
+TARGET = urlscanner-bench
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+INCLUDEPATH += $$PWD/../../src
+
+SOURCES += main.cpp \
+    $$PWD/../../src/urlscanner.cpp
+
+HEADERS += $$PWD/../../src/urlscanner.h
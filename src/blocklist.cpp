@@ -0,0 +1,237 @@
+#include "blocklist.h"
+
+#include <QHostAddress>
+#include <QPair>
+
+static const int IPV4_BITS = 32;
+static const int IPV6_BITS = 128;
+
+static bool has_wildcard(const QString& text)
+{
+    return text.contains('*') || text.contains('?') || text.contains('[') || text.contains(']');
+}
+
+// "192.168.?.1", "10.*.*.1": nothing but address characters around the wildcards
+static bool is_address_wildcard(const QString& text)
+{
+    QString rest = text;
+    rest.remove(QRegExp("[*?\\[\\]]"));
+    return !rest.isEmpty() && QRegExp("[0-9a-f.:]+").exactMatch(rest);
+}
+
+static inline int bit_at(const quint8* bits, int i)
+{
+    return (bits[i / 8] >> (7 - i % 8)) & 1;
+}
+
+static void ipv4_bytes(quint32 address, quint8* bytes)
+{
+    bytes[0] = quint8(address >> 24);
+    bytes[1] = quint8(address >> 16);
+    bytes[2] = quint8(address >> 8);
+    bytes[3] = quint8(address);
+}
+
+BlockList::BlockList()
+{
+    clear();
+}
+
+bool BlockList::add(const QString& rule)
+{
+    QString text = rule.trimmed().toLower();
+    if (text.isEmpty() || m_ruleSet.contains(text)) {
+        return false;
+    }
+    m_rules << text;
+    m_ruleSet.insert(text);
+
+    if (addNetwork(text)) {
+        m_addressRules = true;
+        return true;
+    }
+    if (text.startsWith("*.") && text.length() > 2 && !has_wildcard(text.mid(2))) {
+        addDomain(text.mid(2), true);
+    } else if (!has_wildcard(text)) {
+        addDomain(text, false);
+    } else {
+        m_wildcards << QRegExp(text, Qt::CaseInsensitive, QRegExp::Wildcard);
+        m_addressRules = m_addressRules || is_address_wildcard(text);
+    }
+    return true;
+}
+
+bool BlockList::contains(const QString& host) const
+{
+    QString h = host.toLower();
+    QHostAddress address;
+    if (address.setAddress(h)) {
+        if (containsAddress(address)) {
+            return true;
+        }
+    } else if (containsDomain(h)) {
+        return true;
+    }
+
+    foreach (const QRegExp& wc, m_wildcards) {
+        if (wc.exactMatch(h)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BlockList::isEmpty() const
+{
+    return m_rules.isEmpty();
+}
+
+bool BlockList::hasAddressRules() const
+{
+    return m_addressRules;
+}
+
+void BlockList::clear()
+{
+    m_rules.clear();
+    m_ruleSet.clear();
+    m_domains.clear();
+    m_domains.append(DomainNode());
+    m_ipv4.clear();
+    m_ipv4.append(AddressNode());
+    m_ipv6.clear();
+    m_ipv6.append(AddressNode());
+    m_wildcards.clear();
+    m_addressRules = false;
+}
+
+QStringList BlockList::rules() const
+{
+    return m_rules;
+}
+
+// private:
+// "1.2.3.4", "::1", "10.0.0.0/8", "fc00::/7" and "10.*" / "192.168.*"
+bool BlockList::addNetwork(const QString& rule)
+{
+    QHostAddress address;
+    int length = -1;
+
+    if (rule.contains('/')) {
+        QPair<QHostAddress, int> subnet = QHostAddress::parseSubnet(rule);
+        address = subnet.first;
+        length = subnet.second;
+    } else if (address.setAddress(rule)) {
+        length = address.protocol() == QAbstractSocket::IPv4Protocol ? IPV4_BITS : IPV6_BITS;
+    } else if (rule.endsWith(".*")) {
+        QStringList octets = rule.left(rule.length() - 2).split('.');
+        if (octets.size() > 3) {
+            return false;
+        }
+        quint32 ipv4 = 0;
+        for (int i = 0; i < octets.size(); ++i) {
+            bool ok = false;
+            uint octet = octets.at(i).toUInt(&ok);
+            if (!ok || octet > 255 || octets.at(i).length() > 3) {
+                return false;
+            }
+            ipv4 |= octet << (24 - 8 * i);
+        }
+        address.setAddress(ipv4);
+        length = 8 * octets.size();
+    }
+    if (address.isNull() || length < 0) {
+        return false;
+    }
+
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        quint8 bytes[4];
+        ipv4_bytes(address.toIPv4Address(), bytes);
+        addPrefix(m_ipv4, bytes, length);
+    } else {
+        Q_IPV6ADDR ipv6 = address.toIPv6Address();
+        addPrefix(m_ipv6, ipv6.c, length);
+    }
+    return true;
+}
+
+// reversed labels: "www.example.com" is com -> example -> www
+void BlockList::addDomain(const QString& domain, bool below)
+{
+    QStringList labels = domain.split('.', QString::SkipEmptyParts);
+    int node = 0;
+    for (int i = labels.size() - 1; i >= 0; --i) {
+        int child = m_domains[node].children.value(labels.at(i), -1);
+        if (child < 0) {
+            child = m_domains.size();
+            m_domains[node].children.insert(labels.at(i), child);
+            m_domains.append(DomainNode());
+        }
+        node = child;
+    }
+    if (below) {
+        m_domains[node].below = true;
+    } else {
+        m_domains[node].exact = true;
+    }
+}
+
+void BlockList::addPrefix(QVector<AddressNode>& tree, const quint8* bits, int length)
+{
+    int node = 0;
+    for (int i = 0; i < length; ++i) {
+        int b = bit_at(bits, i);
+        if (tree[node].child[b] < 0) {
+            tree[node].child[b] = tree.size();
+            tree.append(AddressNode());
+        }
+        node = tree[node].child[b];
+    }
+    tree[node].terminal = true;
+}
+
+bool BlockList::matchPrefix(const QVector<AddressNode>& tree, const quint8* bits, int length)
+{
+    int node = 0;
+    for (int i = 0; i < length; ++i) {
+        if (tree[node].terminal) {
+            return true;
+        }
+        node = tree[node].child[bit_at(bits, i)];
+        if (node < 0) {
+            return false;
+        }
+    }
+    return tree[node].terminal;
+}
+
+bool BlockList::containsAddress(const QHostAddress& address) const
+{
+    bool ok = false;
+    quint32 ipv4 = address.toIPv4Address(&ok);
+    if (ok) {
+        // IPv4 and IPv4-mapped IPv6 addresses
+        quint8 bytes[4];
+        ipv4_bytes(ipv4, bytes);
+        return matchPrefix(m_ipv4, bytes, IPV4_BITS);
+    }
+    Q_IPV6ADDR ipv6 = address.toIPv6Address();
+    return matchPrefix(m_ipv6, ipv6.c, IPV6_BITS);
+}
+
+bool BlockList::containsDomain(const QString& host) const
+{
+    QStringList labels = host.split('.', QString::SkipEmptyParts);
+    int node = 0;
+    for (int i = labels.size() - 1; i >= 0; --i) {
+        node = m_domains.at(node).children.value(labels.at(i), -1);
+        if (node < 0) {
+            return false;
+        }
+        // "*.example.com" matches every host with labels left
+        if (i > 0 && m_domains.at(node).below) {
+            return true;
+        }
+    }
+    return labels.size() > 0 && m_domains.at(node).exact;
+}
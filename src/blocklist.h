@@ -0,0 +1,79 @@
+#ifndef BLOCKLIST_H
+#define BLOCKLIST_H
+
+#include <QHash>
+#include <QList>
+#include <QRegExp>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QHostAddress;
+
+/**
+ * The '--block-ip-and-domain' rules, compiled for matching every request
+ * host and every address it resolves to.
+ *
+ *   example.com        the host itself, in a trie of reversed labels
+ *   *.example.com      hosts below it, same trie
+ *   1.2.3.4, ::1       one address, in a binary radix tree per family
+ *   10.0.0.0/8, 10.*   networks, same tree ("a.b.*" is taken as a /16)
+ *   anything else      wildcard pattern, tried one after the other
+ *
+ * A match costs one step per label or prefix bit instead of one wildcard
+ * match per rule; only rules of the last kind are still matched in turn.
+ */
+class BlockList
+{
+public:
+    BlockList();
+
+    /**
+     * @return false if `rule` was empty or added already
+     */
+    bool add(const QString& rule);
+    bool contains(const QString& host) const;
+
+    bool isEmpty() const;
+
+    /**
+     * Whether a rule can match an address (IP, network or an address
+     * like wildcard); without one the addresses of a host do not matter.
+     */
+    bool hasAddressRules() const;
+
+    void clear();
+    QStringList rules() const;
+
+private:
+    struct DomainNode {
+        DomainNode() : exact(false), below(false) {}
+        QHash<QString, int> children;
+        bool exact;
+        bool below;
+    };
+
+    struct AddressNode {
+        AddressNode() : terminal(false) { child[0] = child[1] = -1; }
+        int child[2];
+        bool terminal;
+    };
+
+    bool addNetwork(const QString& rule);
+    void addDomain(const QString& domain, bool below);
+    static void addPrefix(QVector<AddressNode>& tree, const quint8* bits, int length);
+    static bool matchPrefix(const QVector<AddressNode>& tree, const quint8* bits, int length);
+    bool containsAddress(const QHostAddress& address) const;
+    bool containsDomain(const QString& host) const;
+
+    QStringList m_rules;
+    QSet<QString> m_ruleSet;
+    QVector<DomainNode> m_domains;
+    QVector<AddressNode> m_ipv4;
+    QVector<AddressNode> m_ipv6;
+    QList<QRegExp> m_wildcards;
+    bool m_addressRules;
+};
+
+#endif // BLOCKLIST_H
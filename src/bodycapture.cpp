@@ -0,0 +1,137 @@
+#include "bodycapture.h"
+#include "bodystore.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QRegularExpression>
+#include <QTemporaryFile>
+#include <QTextCodec>
+
+// what is read back of a spilled body for URL scanning
+static const qint64 SCAN_PREFIX = 1024 * 1024;
+
+// the types DOMParser::scan_response() scans
+static bool is_scanned(const QString& contentType)
+{
+    static const QRegularExpression textual("javascript|ecmascript|json|css", QRegularExpression::CaseInsensitiveOption);
+    return textual.match(contentType).hasMatch();
+}
+
+BodyCapture::BodyCapture(qint64 memoryLimit, qint64 maxSize, const QString& spillDir)
+    : m_memoryLimit(memoryLimit)
+    , m_maxSize(maxSize)
+    , m_spillDir(spillDir.isEmpty() ? QDir::tempPath() : spillDir)
+    , m_keepFile(!spillDir.isEmpty())
+    , m_file(0)
+    , m_hash(QCryptographicHash::Sha256)
+    , m_size(0)
+    , m_truncated(false)
+{
+}
+
+BodyCapture::~BodyCapture()
+{
+    if (m_file && !m_keepFile) {
+        // moved to the BodyStore already, or not wanted
+        m_file->remove();
+    }
+    delete m_file;
+}
+
+void BodyCapture::append(const QByteArray& data)
+{
+    if (m_truncated || data.isEmpty()) {
+        return;
+    }
+    QByteArray chunk = data;
+    if (m_maxSize > 0 && m_size + chunk.size() > m_maxSize) {
+        chunk.truncate(int(m_maxSize - m_size));
+        m_truncated = true;
+    }
+    if (!m_file && m_buffer.size() + chunk.size() > m_memoryLimit && !spill()) {
+        // no file to spill to, keep what fits in memory
+        chunk.truncate(qMax(0, int(m_memoryLimit - m_buffer.size())));
+        m_truncated = true;
+    }
+    m_hash.addData(chunk);
+    m_size += chunk.size();
+
+    if (m_file) {
+        m_file->write(chunk);
+    } else {
+        m_buffer += chunk;
+    }
+}
+
+void BodyCapture::fill(QVariantMap& record)
+{
+    QByteArray hash = m_hash.result().toHex();
+    record["bodySize"] = m_size;
+    record["bodySha256"] = QString::fromLatin1(hash);
+    if (m_truncated) {
+        record["bodyTruncated"] = true;
+    }
+
+    if (m_file) {
+        // a spilled body stays on disk, only the start of one that is
+        // scanned for URLs comes back
+        QByteArray prefix;
+        if (is_scanned(record.value("contentType").toString())) {
+            m_file->seek(0);
+            prefix = m_file->read(SCAN_PREFIX);
+        }
+        m_file->close();
+
+        if (BodyStore::instance()->isOpen() && BodyStore::instance()->putFile(hash, m_file->fileName())) {
+            record["bodyRef"] = QString::fromLatin1(hash);
+        } else if (m_keepFile) {
+            record["bodyFile"] = m_file->fileName();
+        } else {
+            // not stored, the prefix is all there is
+            record["bodyTruncated"] = true;
+        }
+
+        QTextCodec::ConverterState state;
+        QString text = QTextCodec::codecForName("UTF-8")->toUnicode(prefix.constData(), prefix.size(), &state);
+        record["body"] = state.invalidChars == 0 ? text : QString();
+        return;
+    }
+
+    // the text stays in the record for URL scanning, not in the output
+    const QByteArray& data = m_buffer;
+    if (BodyStore::instance()->isOpen() && BodyStore::instance()->put(hash, data)) {
+        record["bodyRef"] = QString::fromLatin1(hash);
+    }
+
+    QTextCodec::ConverterState state;
+    QString text = QTextCodec::codecForName("UTF-8")->toUnicode(data.constData(), data.size(), &state);
+    // a multi-byte sequence cut by truncation is not binary
+    if (state.invalidChars == 0 && (state.remainingChars == 0 || m_truncated)) {
+        record["body"] = text;
+    } else {
+        record["body"] = "";
+        if (!record.contains("bodyRef")) {
+            record["bodyBase64"] = QString::fromLatin1(data.toBase64());
+        }
+    }
+}
+
+// private:
+bool BodyCapture::spill()
+{
+    // a spilled body is only referenced, it needs a place to stay
+    if (!m_keepFile && !BodyStore::instance()->isOpen()) {
+        return false;
+    }
+    m_file = new QTemporaryFile(m_spillDir + "/bradypod-body-XXXXXX");
+    m_file->setAutoRemove(false);
+    if (!m_file->open()) {
+        qDebug() << "BodyCapture - cannot spill to" << m_spillDir << m_file->errorString();
+        delete m_file;
+        m_file = 0;
+        return false;
+    }
+    m_file->write(m_buffer);
+    m_buffer.clear();
+    return true;
+}
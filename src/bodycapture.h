@@ -0,0 +1,56 @@
+#ifndef BODYCAPTURE_H
+#define BODYCAPTURE_H
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QString>
+#include <QVariantMap>
+
+class QTemporaryFile;
+
+/**
+ * Body of one response, collected chunk by chunk as the reply reads it.
+ *
+ * Bytes stay in memory up to `memoryLimit`, the rest of the body goes to
+ * a file in `spillDir`. A spilled body is never read back whole: it is
+ * moved to the BodyStore, or kept and named by the record when `spillDir`
+ * was given ('--response-body-dir'). With neither, nothing is spilled and
+ * the body is truncated at `memoryLimit`.
+ * Nothing past `maxSize` is stored; the body is then marked truncated.
+ * The SHA-256 covers the stored bytes.
+ */
+class BodyCapture
+{
+public:
+    BodyCapture(qint64 memoryLimit, qint64 maxSize, const QString& spillDir);
+    ~BodyCapture();
+
+    void append(const QByteArray& data);
+
+    /**
+     * Add bodySize, bodySha256, bodyTruncated and either body (UTF-8 text),
+     * bodyBase64 (binary) or bodyFile (spilled, kept) to a response record.
+     * With the BodyStore open the body is stored there and bodyRef names
+     * it. Of a spilled script, JSON or CSS body the first MB is read back
+     * into body for URL scanning; HtmlLoader leaves it out of the output
+     * when bodyRef or bodyFile is there.
+     */
+    void fill(QVariantMap& record);
+
+private:
+    Q_DISABLE_COPY(BodyCapture)
+
+    bool spill();
+
+    qint64 m_memoryLimit;
+    qint64 m_maxSize;
+    QString m_spillDir;
+    bool m_keepFile;
+    QByteArray m_buffer;
+    QTemporaryFile* m_file;
+    QCryptographicHash m_hash;
+    qint64 m_size;
+    bool m_truncated;
+};
+
+#endif // BODYCAPTURE_H
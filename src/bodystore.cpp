@@ -0,0 +1,133 @@
+#include "bodystore.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+BodyStore* BodyStore::instance()
+{
+    static BodyStore store;
+    return &store;
+}
+
+BodyStore::BodyStore()
+    : m_compress(false)
+    , m_stored(0)
+    , m_duplicates(0)
+    , m_duplicateBytes(0)
+    , m_written(0)
+{
+}
+
+bool BodyStore::open(const QString& directory, bool compress, QString* error)
+{
+    if (!QDir().mkpath(directory)) {
+        if (error) {
+            *error = QString("Cannot create body store directory '%1'").arg(directory);
+        }
+        return false;
+    }
+    m_directory = QDir(directory).absolutePath();
+    m_compress = compress;
+    m_known.clear();
+    return true;
+}
+
+bool BodyStore::isOpen() const
+{
+    return !m_directory.isEmpty();
+}
+
+bool BodyStore::put(const QByteArray& hash, const QByteArray& data)
+{
+    if (contains(hash)) {
+        m_duplicates++;
+        m_duplicateBytes += data.size();
+        return true;
+    }
+    if (!write(path(hash), m_compress ? qCompress(data) : data)) {
+        return false;
+    }
+    m_known.insert(hash);
+    m_stored++;
+    return true;
+}
+
+bool BodyStore::putFile(const QByteArray& hash, const QString& filePath)
+{
+    if (contains(hash)) {
+        m_duplicates++;
+        m_duplicateBytes += QFileInfo(filePath).size();
+        QFile::remove(filePath);
+        return true;
+    }
+
+    QString target = path(hash);
+    bool stored;
+    if (m_compress) {
+        QFile file(filePath);
+        stored = file.open(QIODevice::ReadOnly) && write(target, qCompress(file.readAll()));
+        file.close();
+        file.remove();
+    } else {
+        qint64 size = QFileInfo(filePath).size();
+        QDir().mkpath(QFileInfo(target).path());
+        // a rename does not cross file systems, copy then
+        stored = QFile::rename(filePath, target)
+                || (QFile::copy(filePath, target) && QFile::remove(filePath));
+        if (stored) {
+            m_written += size;
+        }
+    }
+    if (!stored) {
+        qDebug() << "BodyStore - cannot store" << filePath << "as" << target;
+        return false;
+    }
+    m_known.insert(hash);
+    m_stored++;
+    return true;
+}
+
+QVariantMap BodyStore::stats() const
+{
+    QVariantMap stats;
+    stats["stored"] = m_stored;
+    stats["duplicates"] = m_duplicates;
+    stats["duplicate_bytes"] = m_duplicateBytes;
+    stats["written_bytes"] = m_written;
+    return stats;
+}
+
+// private:
+QString BodyStore::path(const QByteArray& hash) const
+{
+    QString name = QString::fromLatin1(hash);
+    return m_directory + "/" + name.left(2) + "/" + name + (m_compress ? ".z" : "");
+}
+
+// bodies of earlier runs (or other workers) are found on disk
+bool BodyStore::contains(const QByteArray& hash)
+{
+    if (m_known.contains(hash)) {
+        return true;
+    }
+    if (QFile::exists(path(hash))) {
+        m_known.insert(hash);
+        return true;
+    }
+    return false;
+}
+
+bool BodyStore::write(const QString& filePath, const QByteArray& data)
+{
+    QDir().mkpath(QFileInfo(filePath).path());
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qDebug() << "BodyStore - cannot write" << filePath << file.errorString();
+        return false;
+    }
+    m_written += data.size();
+    return true;
+}
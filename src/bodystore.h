@@ -0,0 +1,58 @@
+#ifndef BODYSTORE_H
+#define BODYSTORE_H
+
+#include <QByteArray>
+#include <QSet>
+#include <QString>
+#include <QVariantMap>
+
+/**
+ * Process wide content-addressed store of response bodies ('--body-store').
+ *
+ * A body is written once to <dir>/<first 2 hex digits>/<sha256>, with a
+ * ".z" suffix when compressed (qCompress, '--body-store-compress');
+ * records refer to it by "bodyRef" instead of carrying it. The same
+ * script or stylesheet fetched by every page of a crawl is stored once.
+ */
+class BodyStore
+{
+public:
+    static BodyStore* instance();
+
+    bool open(const QString& directory, bool compress, QString* error = 0);
+    bool isOpen() const;
+
+    /**
+     * Store `data` under its hex SHA-256 `hash`, unless it is there already.
+     */
+    bool put(const QByteArray& hash, const QByteArray& data);
+
+    /**
+     * Same for a body spilled to `filePath`; the file is moved or removed.
+     */
+    bool putFile(const QByteArray& hash, const QString& filePath);
+
+    /**
+     * Bodies written, bodies already stored and the bytes they would have
+     * taken, bytes written.
+     */
+    QVariantMap stats() const;
+
+private:
+    BodyStore();
+
+    QString path(const QByteArray& hash) const;
+    bool contains(const QByteArray& hash);
+    bool write(const QString& filePath, const QByteArray& data);
+
+    QString m_directory;
+    bool m_compress;
+    QSet<QByteArray> m_known;
+
+    qint64 m_stored;
+    qint64 m_duplicates;
+    qint64 m_duplicateBytes;
+    qint64 m_written;
+};
+
+#endif // BODYSTORE_H
@@ -1,6 +1,7 @@
 #include "bradypod.h"
 
 #include <QApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QFile>
@@ -8,7 +9,11 @@
 #include <QMetaObject>
 #include <QMetaProperty>
 #include <QScreen>
+#include <QSocketNotifier>
 #include <QStandardPaths>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QTimer>
 #include <QWebPage>
 
 #include "callback.h"
@@ -19,6 +24,20 @@
 #include "utils.h"
 #include "webpage.h"
 #include "htmlloader.h"
+#include "pagepool.h"
+#include "jobserver.h"
+#include "frontier.h"
+#include "bodystore.h"
+#include "dnscache.h"
+#include "requestscheduler.h"
+#include "memorywatchdog.h"
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#endif
 
 static Bradypod* bradypodInstance = NULL;
 
@@ -30,9 +49,21 @@ Bradypod::Bradypod(QObject* parent)
     , m_returnValue(0)
     , m_filesystem(0)
     , m_system(0)
+    , m_urlListFile(0)
+    , m_urlListStream(0)
+    , m_urlListNotifier(0)
+    , m_urlListEof(false)
+    , m_urlListSkip(0)
+    , m_pool(0)
+    , m_server(0)
+    , m_frontier(0)
+    , m_urlListLines(0)
+    , m_checkpointTimer(0)
+    , m_checkpointGeneration(0)
+    , m_batchCount(0)
+    , m_watchdog(0)
 {
     QStringList args = QApplication::arguments();
-    m_start_time = QDateTime::currentDateTime();
 
     // Prepare the configuration object based on the command line arguments.
     // Because this object will be used by other classes, it needs to be ready ASAP.
@@ -41,10 +72,7 @@ Bradypod::Bradypod(QObject* parent)
     // Apply debug configuration as early as possible
     Utils::printDebugMessages = m_config->printDebugMessages();
 
-    m_parsedDataStore["start_time"] = m_start_time.toString(Qt::ISODateWithMs);
-    m_parsedDataStore["url"] = m_config->resourceUrl();
     m_parsedDataStore["commandline"] = args;
-    m_parsedDataStore["data"] = QVariantList();
 }
 
 void Bradypod::init()
@@ -71,11 +99,22 @@ void Bradypod::init()
 
     // Initialize the CookieJar
     m_defaultCookieJar = new CookieJar(m_config->cookiesFile());
-    if (m_config->cookies().length() > 0) {
-        setCookies(m_config->cookies());
-    }
-    if (m_config->cookiejarData().length() > 0) {
-        m_defaultCookieJar->addCookiesFromMap(m_config->cookiejarData());
+    applyConfigCookies(m_defaultCookieJar, m_config->resourceUrl());
+
+    // per-host politeness, shared by the requests of every page
+    RequestScheduler::instance()->setLimits(m_config->maxHostConnections(), m_config->hostDelay(), m_config->hostBandwidth());
+
+    // host lookups for the block list, shared by every page
+    DnsCache::instance()->setTtl(m_config->dnsTtl(), m_config->dnsNegativeTtl());
+
+    // response bodies shared by every page, stored once
+    if (!m_config->bodyStore().isEmpty()) {
+        QString error;
+        if (!BodyStore::instance()->open(m_config->bodyStore(), m_config->bodyStoreCompress(), &error)) {
+            Terminal::instance()->cerr(error);
+            m_terminated = true;
+            return;
+        }
     }
 
     // set the default DPI
@@ -112,16 +151,7 @@ void Bradypod::init()
     connect(m_page, SIGNAL(initialized()),
             SLOT(onInitialized()));
 
-    m_defaultPageSettings[PAGE_SETTINGS_LOAD_IMAGES] = QVariant::fromValue(m_config->autoLoadImages());
-    m_defaultPageSettings[PAGE_SETTINGS_JS_ENABLED] = QVariant::fromValue(m_config->javascriptEnabled());
-    m_defaultPageSettings[PAGE_SETTINGS_XSS_AUDITING] = QVariant::fromValue(m_config->webSecurityEnabled());
-    m_defaultPageSettings[PAGE_SETTINGS_USER_AGENT] = QVariant::fromValue(m_config->userAgent());
-    m_defaultPageSettings[PAGE_SETTINGS_LOCAL_ACCESS_REMOTE] = QVariant::fromValue(m_config->localToRemoteUrlAccessEnabled());
-    m_defaultPageSettings[PAGE_SETTINGS_WEB_SECURITY_ENABLED] = QVariant::fromValue(m_config->webSecurityEnabled());
-    m_defaultPageSettings[PAGE_SETTINGS_JS_CAN_OPEN_WINDOWS] = QVariant::fromValue(m_config->javascriptCanOpenWindows());
-    m_defaultPageSettings[PAGE_SETTINGS_JS_CAN_CLOSE_WINDOWS] = QVariant::fromValue(m_config->javascriptCanCloseWindows());
-    m_defaultPageSettings[PAGE_SETTINGS_RESOURCE_TIMEOUT] = QVariant::fromValue(m_config->resourceTimeout());
-    m_defaultPageSettings[PAGE_SETTINGS_DPI] = QVariant::fromValue(m_defaultDpi);
+    m_defaultPageSettings = pageSettings(m_config);
     m_page->applySettings(m_defaultPageSettings);
 
     setLibraryPath(QDir::currentPath());
@@ -147,6 +177,22 @@ QVariantMap Bradypod::defaultPageSettings() const
     return m_defaultPageSettings;
 }
 
+QVariantMap Bradypod::pageSettings(const Config* config) const
+{
+    QVariantMap settings;
+    settings[PAGE_SETTINGS_LOAD_IMAGES] = QVariant::fromValue(config->autoLoadImages());
+    settings[PAGE_SETTINGS_JS_ENABLED] = QVariant::fromValue(config->javascriptEnabled());
+    settings[PAGE_SETTINGS_XSS_AUDITING] = QVariant::fromValue(config->webSecurityEnabled());
+    settings[PAGE_SETTINGS_USER_AGENT] = QVariant::fromValue(config->userAgent());
+    settings[PAGE_SETTINGS_LOCAL_ACCESS_REMOTE] = QVariant::fromValue(config->localToRemoteUrlAccessEnabled());
+    settings[PAGE_SETTINGS_WEB_SECURITY_ENABLED] = QVariant::fromValue(config->webSecurityEnabled());
+    settings[PAGE_SETTINGS_JS_CAN_OPEN_WINDOWS] = QVariant::fromValue(config->javascriptCanOpenWindows());
+    settings[PAGE_SETTINGS_JS_CAN_CLOSE_WINDOWS] = QVariant::fromValue(config->javascriptCanCloseWindows());
+    settings[PAGE_SETTINGS_RESOURCE_TIMEOUT] = QVariant::fromValue(config->resourceTimeout());
+    settings[PAGE_SETTINGS_DPI] = QVariant::fromValue(m_defaultDpi);
+    return settings;
+}
+
 QString Bradypod::outputEncoding() const
 {
     return Terminal::instance()->getEncoding();
@@ -174,7 +220,7 @@ bool Bradypod::execute()
     qDebug() << "    " << "URL:" << m_config->resourceUrl();
 #endif
 
-    if (m_config->resourceUrl().isEmpty()) {
+    if (m_config->resourceUrl().isEmpty() && m_config->urlList().isEmpty() && m_config->serve().isEmpty()) {
         Terminal::instance()->cout(m_config->helpText());
         return false;
     }
@@ -186,6 +232,75 @@ bool Bradypod::execute()
 #endif
     }
 
+    m_watchdog = new MemoryWatchdog(this, m_config);
+    connect(m_watchdog, SIGNAL(hardLimitExceeded(qint64)), SLOT(onMemoryLimit(qint64)));
+    m_watchdog->start();
+
+    if (!m_config->serve().isEmpty()) {
+        m_pool = new PagePool(this, m_config->concurrency());
+        m_server = new JobServer(this, m_pool);
+        if (!m_server->listen(m_config->serve())) {
+            Terminal::instance()->cerr(QString("Listen on '%1' error: %2").arg(m_config->serve(), m_server->errorString()));
+            exit(1);
+            return false;
+        }
+        return !m_terminated;
+    }
+
+    if (!m_config->urlList().isEmpty() || m_config->crawlDepth() > 0) {
+        if (!m_config->urlList().isEmpty() && !openUrlList()) {
+            return false;
+        }
+
+        if (m_config->crawlDepth() > 0) {
+            m_frontier = new Frontier(this, m_config);
+        }
+
+        // the crawl keeps one session, the checkpoints save its cookies
+        m_pool = new PagePool(this, m_config->concurrency());
+        m_pool->setSharedCookies(true);
+
+        if (!m_config->resume().isEmpty()) {
+            if (!loadCheckpoint(m_config->resume())) {
+                exit(1);
+                return false;
+            }
+        } else {
+            // records are appended one per URL, start with an empty output file
+            if (!m_config->outputFile().isEmpty()) {
+                QFile output(m_config->outputFile());
+                if (output.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+                    output.close();
+                }
+            }
+            if (m_frontier && m_config->urlList().isEmpty()) {
+                m_frontier->addSeed(m_config->resourceUrl());
+            }
+        }
+
+        m_checkpointDir = m_config->checkpoint().isEmpty() ? m_config->resume() : m_config->checkpoint();
+        if (!m_checkpointDir.isEmpty()) {
+            m_checkpointTimer = new QTimer(this);
+            connect(m_checkpointTimer, SIGNAL(timeout()), SLOT(saveCheckpoint()));
+            m_checkpointTimer->start(m_config->checkpointInterval() * 1000);
+        }
+
+        connect(m_pool, SIGNAL(jobsWanted(int)), SLOT(onJobsWanted(int)));
+        connect(m_pool, SIGNAL(jobFinished(QVariantMap)), SLOT(onJobFinished(QVariantMap)));
+        connect(m_pool, SIGNAL(drained()), SLOT(onPoolDrained()));
+        onJobsWanted(m_pool->concurrency());
+        if (m_pool->isIdle() && !urlListPending()) {
+            if (!m_config->resume().isEmpty()) {
+                Terminal::instance()->cerr(QString("Nothing left to resume in '%1'").arg(m_config->resume()));
+            } else {
+                Terminal::instance()->cerr(QString("No URL found in '%1'").arg(m_config->urlList().isEmpty() ? m_config->resourceUrl() : m_config->urlList()));
+            }
+            exit(0);
+            return false;
+        }
+        return !m_terminated;
+    }
+
     html_loader()->loadUrl(m_config->resourceUrl());
 
     return !m_terminated;
@@ -224,8 +339,10 @@ HtmlLoader* Bradypod::html_loader()
 {
     if (m_html_loader)
         return m_html_loader;
-    else
+    else {
         m_html_loader = new HtmlLoader(this,0);
+        connect(m_html_loader, SIGNAL(finished()), SLOT(onLoaderFinished()));
+    }
     return m_html_loader;
 }
 
@@ -234,6 +351,16 @@ Config* Bradypod::config() const
     return m_config;
 }
 
+bool Bradypod::isBatchMode() const
+{
+    return m_pool != 0 && m_server == 0;
+}
+
+bool Bradypod::isServeMode() const
+{
+    return m_server != 0;
+}
+
 bool Bradypod::printDebugMessages() const
 {
     return m_config->printDebugMessages();
@@ -264,7 +391,13 @@ QObject* Bradypod::createWebPage()
     WebPage* page = new WebPage(this);
     page->setCookieJar(m_defaultCookieJar);
 
-    // Store pointer to the page for later cleanup
+    // Store pointer to the page for later cleanup, forget pages the pool retired
+    QMutableListIterator<QPointer<WebPage> > i(m_pages);
+    while (i.hasNext()) {
+        if (i.next().isNull()) {
+            i.remove();
+        }
+    }
     m_pages.append(page);
     // Apply default settings to the page
     page->applySettings(m_defaultPageSettings);
@@ -388,6 +521,23 @@ static bool writeData2File(const QByteArray& data, const QString& fileName)
     return true;
 }
 
+static bool appendData2File(const QByteArray& data, const QString& fileName)
+{
+    if (fileName.isEmpty()) {
+        Terminal::instance()->cout(QString::fromUtf8(data));
+    } else {
+        QFile file(fileName);
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            Terminal::instance()->cerr(QString("Open File[%1] error: %2").arg(fileName,file.errorString()));
+            return false;
+        }
+        file.write(data);
+        file.write("\n");
+        file.close();
+    }
+    return true;
+}
+
 void Bradypod::exit(int code)
 {
     if (m_config->debug() && m_config->remoteDebugPort() != 0) {
@@ -396,9 +546,10 @@ void Bradypod::exit(int code)
         doExit(code);
     }
 
-    m_end_time = QDateTime::currentDateTime();
-    m_parsedDataStore["end_time"] = m_end_time.toString(Qt::ISODateWithMs);
-    m_parsedDataStore["time_cost"] = m_start_time.msecsTo(m_end_time);
+    // batch and serve mode have already written one record per URL
+    if (isBatchMode() || isServeMode()) {
+        return;
+    }
 
     // export result
     if (m_config->outputFormat() == "json") {
@@ -445,6 +596,54 @@ void Bradypod::onInitialized()
 //    m_page->mainFrame()->evaluateJavaScript(Utils::readResourceFileUtf8(":/bootstrap.js"));
 }
 
+void Bradypod::onLoaderFinished()
+{
+    exit(1);
+}
+
+void Bradypod::onJobsWanted(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        QVariantMap job = nextJob();
+        if (job.isEmpty()) {
+            break;
+        }
+        m_batchCount++;
+        m_pool->enqueue(job);
+    }
+}
+
+void Bradypod::onJobFinished(const QVariantMap& record)
+{
+    if (m_frontier) {
+        m_frontier->addLinks(record);
+    }
+
+    QVariantMap data(m_parsedDataStore);
+    QMapIterator<QString, QVariant> i(record);
+    while (i.hasNext()) {
+        i.next();
+        data[i.key()] = i.value();
+    }
+    writeRecord(data);
+}
+
+void Bradypod::onPoolDrained()
+{
+    if (m_terminated || urlListPending()) {
+        // more URLs may come on stdin
+        return;
+    }
+    qDebug() << "Bradypod - url list done:" << m_batchCount << "URL(s)";
+    if (!m_checkpointDir.isEmpty()) {
+        m_checkpointTimer->stop();
+        saveCheckpoint();
+    } else if (m_frontier) {
+        m_frontier->seen().flush();
+    }
+    exit(0);
+}
+
 bool Bradypod::setCookies(const QVariantList& cookies)
 {
     // Delete all the cookies from the CookieJar
@@ -477,6 +676,21 @@ bool Bradypod::setCookies(const QString& cookies_str)
     return true;
 }
 
+void Bradypod::applyConfigCookies(CookieJar* jar, const QString& url)
+{
+    applyCookies(jar, url, m_config->cookies(), m_config->cookiejarData());
+}
+
+void Bradypod::applyCookies(CookieJar* jar, const QString& url, const QString& cookies, const QVariantList& cookiejarData)
+{
+    if (cookies.length() > 0) {
+        jar->setCookiesFromUrl(parseSimpleCookie(cookies), QUrl(url));
+    }
+    if (cookiejarData.length() > 0) {
+        jar->addCookiesFromMap(cookiejarData);
+    }
+}
+
 QVariantList Bradypod::cookies() const
 {
     // Return all the Cookies in the CookieJar, as a list of Maps (aka JSON in JS space)
@@ -502,6 +716,25 @@ void Bradypod::clearCookies()
 }
 
 
+void Bradypod::onMemoryLimit(qint64 rss)
+{
+    if (m_terminated) {
+        return;
+    }
+    if (m_pool) {
+        m_pool->abort("memory_limit");
+        return;
+    }
+
+    // single URL: give up the page, the result carries what was collected
+    m_parsedDataStore["error"] = "memory_limit";
+    m_parsedDataStore["rss"] = rss;
+    if (m_html_loader) {
+        m_html_loader->webpage()->stop();
+    }
+    exit(1);
+}
+
 // private:
 void Bradypod::doExit(int code)
 {
@@ -531,41 +764,277 @@ void Bradypod::doExit(int code)
     QApplication::instance()->exit(code);
 }
 
-QVariantMap Bradypod::getParsedDataStore() const
+// Read by the worker while the event loop runs: lines are taken from the
+// supervisor pipe when it is readable, a partial line waits for the rest.
+void Bradypod::onUrlListReadable()
 {
-    QVariantMap data(m_parsedDataStore);
-    data["data"] = m_requestData;
-    data["cookiejar"] = m_defaultCookieJar->cookiesToMap();
-    data["page_content"] = m_html_loader->getHtmlContent();
-    return data;
+#ifdef Q_OS_UNIX
+    char buffer[4096];
+    forever {
+        ssize_t size = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+        if (size > 0) {
+            m_urlListBuffer.append(buffer, int(size));
+            continue;
+        }
+        if (size < 0 && errno == EINTR) {
+            continue;
+        }
+        if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        if (size < 0) {
+            qDebug() << "Bradypod - read url list error:" << strerror(errno);
+        }
+        m_urlListEof = true;
+        m_urlListNotifier->setEnabled(false);
+        break;
+    }
+#endif
+
+    int start = 0;
+    int end;
+    while ((end = m_urlListBuffer.indexOf('\n', start)) >= 0) {
+        m_urlListPending.enqueue(m_urlListBuffer.mid(start, end - start));
+        start = end + 1;
+    }
+    m_urlListBuffer.remove(0, start);
+    if (m_urlListEof && !m_urlListBuffer.isEmpty()) {
+        // last line without a newline
+        m_urlListPending.enqueue(m_urlListBuffer);
+        m_urlListBuffer.clear();
+    }
+
+    if (!m_pool || m_terminated) {
+        return;
+    }
+    onJobsWanted(m_pool->concurrency() - m_pool->active() - m_pool->pending());
+    if (m_pool->isIdle()) {
+        onPoolDrained();
+    }
 }
 
-void Bradypod::addParsedData(const QVariant& data)
+bool Bradypod::openUrlList()
 {
-    QVariantMap dataMap = data.toMap();
-//    qDebug()<<"data:"<<data;
-    QString id = dataMap["id"].toString();
-    if (!m_requestData.contains(id)) {
-        m_requestData[id] = QVariantMap();
+    QString fileName = m_config->urlList();
+
+#ifdef Q_OS_UNIX
+    if (fileName == "-") {
+        // a blocking read of the pipe would stall the event loop, and with
+        // it every page, until the supervisor sends the next URL
+        int flags = ::fcntl(STDIN_FILENO, F_GETFL);
+        if (flags < 0 || ::fcntl(STDIN_FILENO, F_SETFL, flags | O_NONBLOCK) < 0) {
+            Terminal::instance()->cerr(QString("Open File[%1] error: %2").arg(fileName, strerror(errno)));
+            return false;
+        }
+        m_urlListNotifier = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+        connect(m_urlListNotifier, SIGNAL(activated(int)), SLOT(onUrlListReadable()));
+        return true;
     }
-    QVariantMap req = m_requestData[id].toMap();
-    QString type = dataMap["type"].toString();
-    if (type == "finished")
-    {
-        if (req.contains("response")){
-            // ignore
-            return;
+#endif
+
+    m_urlListFile = new QFile(this);
+    bool opened = false;
+    if (fileName == "-") {
+        opened = m_urlListFile->open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    } else {
+        m_urlListFile->setFileName(fileName);
+        opened = m_urlListFile->open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        Terminal::instance()->cerr(QString("Open File[%1] error: %2").arg(fileName, m_urlListFile->errorString()));
+        return false;
+    }
+
+    m_urlListStream = new QTextStream(m_urlListFile);
+    m_urlListStream->setCodec("utf-8");
+    return true;
+}
+
+QString Bradypod::readNextUrl()
+{
+    forever {
+        QString line;
+        if (m_urlListNotifier) {
+            if (m_urlListPending.isEmpty()) {
+                break;
+            }
+            line = QString::fromUtf8(m_urlListPending.dequeue()).trimmed();
+        } else if (m_urlListStream && !m_urlListStream->atEnd()) {
+            line = m_urlListStream->readLine().trimmed();
         } else {
-            type = "response";
+            break;
+        }
+        m_urlListLines++;
+        // skip the part read before the checkpoint, blank lines and comments
+        if (m_urlListLines <= m_urlListSkip || line.isEmpty() || line.startsWith('#')) {
+            continue;
         }
+        return line;
     }
-    dataMap.remove("id");
-    dataMap.remove("type");
-    dataMap.remove("stage");
-    qDebug()<<"type: "<< type;
-    req[type] = dataMap;
-//    m_requestData.remove(id);
-    m_requestData[id] = req;
+    return QString();
+}
+
+bool Bradypod::urlListPending() const
+{
+    return m_urlListNotifier && (!m_urlListEof || !m_urlListPending.isEmpty());
+}
+
+QVariantMap Bradypod::nextJob()
+{
+    // unfinished jobs of the checkpoint go first
+    if (!m_resumeJobs.isEmpty()) {
+        return m_resumeJobs.dequeue();
+    }
+
+    if (!m_frontier) {
+        QVariantMap job;
+        QString url = readNextUrl();
+        if (!url.isEmpty()) {
+            job["url"] = url;
+        }
+        return job;
+    }
+
+    // the url list only seeds the crawl, read it as the frontier runs dry
+    while (m_frontier->size() == 0) {
+        QString url = readNextUrl();
+        if (url.isEmpty()) {
+            break;
+        }
+        m_frontier->addSeed(url);
+    }
+    return m_frontier->next();
+}
+
+// checkpoint directory:
+//   checkpoint.json  counters, unfinished jobs, frontier queue, cookies
+//   seen.<0|1>.bin   frontier seen set, named by checkpoint.json
+void Bradypod::saveCheckpoint()
+{
+    if (!QDir().mkpath(m_checkpointDir)) {
+        Terminal::instance()->cerr(QString("Create checkpoint directory '%1' error").arg(m_checkpointDir));
+        return;
+    }
+    QDir dir(m_checkpointDir);
+
+    // m_batchCount counts the jobs handed to the pool, not the pending resumed ones
+    QVariantList jobs;
+    foreach (const QVariantMap& job, m_pool->jobs()) {
+        jobs << job;
+    }
+    int done = m_batchCount - jobs.size();
+    foreach (const QVariantMap& job, m_resumeJobs) {
+        jobs << job;
+    }
+
+    QVariantMap state;
+    state["version"] = 1;
+    state["time"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    state["batch_count"] = done;
+    state["url_list_lines"] = qMax(m_urlListLines, m_urlListSkip);
+    state["output_offset"] = m_config->outputFile().isEmpty() ? -1 : QFileInfo(m_config->outputFile()).size();
+    state["jobs"] = jobs;
+    state["cookies"] = m_pool->cookieJar()->cookiesToMap();
+
+    if (m_frontier) {
+        // the seen set goes first, the previous one stays valid until the
+        // new checkpoint.json points to this one
+        m_checkpointGeneration = 1 - m_checkpointGeneration;
+        QString seenFile = QString("seen.%1.bin").arg(m_checkpointGeneration);
+        if (!m_frontier->seen().save(dir.filePath(seenFile))) {
+            Terminal::instance()->cerr(QString("Write checkpoint '%1' error").arg(dir.filePath(seenFile)));
+            return;
+        }
+        state["frontier"] = m_frontier->state();
+        state["seen_file"] = seenFile;
+    }
+
+    QSaveFile file(dir.filePath("checkpoint.json"));
+    if (!file.open(QIODevice::WriteOnly)) {
+        Terminal::instance()->cerr(QString("Write checkpoint '%1' error: %2").arg(file.fileName(), file.errorString()));
+        return;
+    }
+    file.write(QJsonDocument(QJsonObject::fromVariantMap(state)).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        Terminal::instance()->cerr(QString("Write checkpoint '%1' error: %2").arg(file.fileName(), file.errorString()));
+        return;
+    }
+    // the bloom filter of '--seen-file' may now skip what this checkpoint saw
+    if (m_frontier) {
+        m_frontier->seen().flush();
+    }
+    qDebug() << "Bradypod - checkpoint saved:" << done << "URL(s) done," << jobs.size() << "unfinished";
+}
+
+bool Bradypod::loadCheckpoint(const QString& dirPath)
+{
+    QDir dir(dirPath);
+    QFile file(dir.filePath("checkpoint.json"));
+    if (!file.open(QIODevice::ReadOnly)) {
+        Terminal::instance()->cerr(QString("Open File[%1] error: %2").arg(file.fileName(), file.errorString()));
+        return false;
+    }
+    QVariantMap state = QJsonDocument::fromJson(file.readAll()).object().toVariantMap();
+    if (state.value("version").toInt() != 1) {
+        Terminal::instance()->cerr(QString("'%1' is not a checkpoint").arg(file.fileName()));
+        return false;
+    }
+
+    if (m_frontier && state.contains("frontier")) {
+        QString seenFile = state.value("seen_file").toString();
+        if (!m_frontier->seen().load(dir.filePath(seenFile))) {
+            Terminal::instance()->cerr(QString("Read checkpoint '%1' error").arg(dir.filePath(seenFile)));
+            return false;
+        }
+        m_checkpointGeneration = seenFile == "seen.1.bin" ? 1 : 0;
+        m_frontier->restore(state.value("frontier").toMap());
+    }
+
+    // drop records written after the checkpoint, their jobs run again
+    qint64 offset = state.value("output_offset").toLongLong();
+    if (!m_config->outputFile().isEmpty() && offset >= 0) {
+        QFile output(m_config->outputFile());
+        if (output.exists() && output.size() > offset) {
+            output.resize(offset);
+        }
+    }
+
+    // skip the part of the url list that was read already
+    // (stdin is skipped as it comes in, see readNextUrl())
+    int lines = state.value("url_list_lines").toInt();
+    while (m_urlListStream && m_urlListLines < lines && !m_urlListStream->atEnd()) {
+        m_urlListStream->readLine();
+        m_urlListLines++;
+    }
+    m_urlListSkip = lines;
+
+    foreach (const QVariant& job, state.value("jobs").toList()) {
+        m_resumeJobs.enqueue(job.toMap());
+    }
+    m_batchCount = state.value("batch_count").toInt();
+    m_pool->cookieJar()->addCookiesFromMap(state.value("cookies").toList());
+
+    qDebug() << "Bradypod - resume from" << state.value("time").toString() << ":" << m_batchCount << "URL(s) done,"
+             << m_resumeJobs.size() << "unfinished";
+    return true;
+}
+
+QVariantMap Bradypod::getParsedDataStore() const
+{
+    QVariantMap data(m_parsedDataStore);
+    if (m_html_loader) {
+        QMapIterator<QString, QVariant> i(m_html_loader->result());
+        while (i.hasNext()) {
+            i.next();
+            data[i.key()] = i.value();
+        }
+    }
+    return data;
+}
+
+void Bradypod::addParsedData(const QVariant& data)
+{
+    html_loader()->addParsedData(data);
 }
 
 QJsonObject Bradypod::storeToJson() const
@@ -629,3 +1098,15 @@ QDomDocument Bradypod::storeToXml() const
     QDomDocument doc = json2xml(data);
     return doc;
 }
+
+void Bradypod::writeRecord(const QVariantMap& record)
+{
+    // one record per line
+    if (m_config->outputFormat() == "json") {
+        QJsonDocument jdoc(QJsonObject::fromVariantMap(record));
+        appendData2File(jdoc.toJson(QJsonDocument::Compact), m_config->outputFile());
+    } else {
+        QDomDocument xml = json2xml(record);
+        appendData2File(xml.toByteArray(-1), m_config->outputFile());
+    }
+}
@@ -6,6 +6,7 @@
 #include <QJsonDocument>
 #include <QDomDocument>
 #include <QDateTime>
+#include <QQueue>
 
 #include "filesystem.h"
 #include "encoding.h"
@@ -13,8 +14,16 @@
 #include "system.h"
 #include "cookiejar.h"
 
+class QFile;
+class QSocketNotifier;
+class QTimer;
+class QTextStream;
 class WebPage;
 class HtmlLoader;
+class PagePool;
+class JobServer;
+class Frontier;
+class MemoryWatchdog;
 class CustomWebPage;
 class WebServer;
 
@@ -40,6 +49,11 @@ public:
     virtual ~Bradypod();
 
     QVariantMap defaultPageSettings() const;
+    /**
+     * Page settings (see WebPage::applySettings) derived from `config`,
+     * defaultPageSettings() is pageSettings(config()).
+     */
+    QVariantMap pageSettings(const Config* config) const;
 
     QString outputEncoding() const;
     void setOutputEncoding(const QString& encoding);
@@ -72,6 +86,26 @@ public:
 
     int remoteDebugPort() const;
 
+    /**
+     * Batch mode is enabled by '--url-list' or '--crawl-depth': URLs are
+     * read one per line (or taken from the crawl frontier) and loaded by a
+     * pool of '--concurrency' reused pages, writing one result record per URL.
+     */
+    bool isBatchMode() const;
+
+    /**
+     * Serve mode is enabled by '--serve': the process stays resident and
+     * runs the jobs it receives on the page pool, see JobServer.
+     */
+    bool isServeMode() const;
+
+    /**
+     * Apply the cookies given on the command line ('--cookies', '--cookiejar')
+     * to `jar`, as seen from `url`.
+     */
+    void applyConfigCookies(CookieJar* jar, const QString& url);
+    void applyCookies(CookieJar* jar, const QString& url, const QString& cookies, const QVariantList& cookiejarData);
+
     QVariantMap getParsedDataStore() const;
     QJsonObject storeToJson() const;
     QDomDocument storeToXml() const;
@@ -194,9 +228,24 @@ private slots:
 
     void onInitialized();
 
+    void onLoaderFinished();
+    void onJobsWanted(int count);
+    void onJobFinished(const QVariantMap& record);
+    void onPoolDrained();
+    void onUrlListReadable();
+    void saveCheckpoint();
+    void onMemoryLimit(qint64 rss);
+
 private:
     void doExit(int code);
 
+    bool openUrlList();
+    QString readNextUrl();
+    bool urlListPending() const;
+    QVariantMap nextJob();
+    bool loadCheckpoint(const QString& dir);
+    void writeRecord(const QVariantMap& record);
+
     Encoding m_scriptFileEnc;
     WebPage* m_page;
     HtmlLoader* m_html_loader;
@@ -212,9 +261,23 @@ private:
     CookieJar* m_defaultCookieJar;
     qreal m_defaultDpi;
     QVariantMap m_parsedDataStore;
-    QVariantMap m_requestData;
-    QDateTime m_start_time;
-    QDateTime m_end_time;
+    QFile* m_urlListFile;
+    QTextStream* m_urlListStream;
+    QSocketNotifier* m_urlListNotifier;
+    QByteArray m_urlListBuffer;
+    QQueue<QByteArray> m_urlListPending;
+    bool m_urlListEof;
+    int m_urlListSkip;
+    PagePool* m_pool;
+    JobServer* m_server;
+    Frontier* m_frontier;
+    int m_urlListLines;
+    QQueue<QVariantMap> m_resumeJobs;
+    QString m_checkpointDir;
+    QTimer* m_checkpointTimer;
+    int m_checkpointGeneration;
+    int m_batchCount;
+    MemoryWatchdog* m_watchdog;
     friend class CustomWebPage;
 };
 
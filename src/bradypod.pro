@@ -44,7 +44,22 @@ SOURCES += main.cpp\
     qcommandline.cpp \
     callback.cpp \
     domparser.cpp \
+    domwalker.cpp \
+    domtags.cpp \
     htmlloader.cpp \
+    pagepool.cpp \
+    jobserver.cpp \
+    frontier.cpp \
+    seenset.cpp \
+    requestscheduler.cpp \
+    memorywatchdog.cpp \
+    urlscanner.cpp \
+    formreplay.cpp \
+    dnscache.cpp \
+    blocklist.cpp \
+    resourcefilter.cpp \
+    bodycapture.cpp \
+    bodystore.cpp \
     qwebviewaccessible.cpp
 
 HEADERS  += \
@@ -64,7 +79,22 @@ HEADERS  += \
     qcommandline.h \
     callback.h \
     domparser.h \
-    htmlloader.h
+    domwalker.h \
+    domtags.h \
+    htmlloader.h \
+    pagepool.h \
+    jobserver.h \
+    frontier.h \
+    seenset.h \
+    requestscheduler.h \
+    memorywatchdog.h \
+    urlscanner.h \
+    formreplay.h \
+    dnscache.h \
+    blocklist.h \
+    resourcefilter.h \
+    bodycapture.h \
+    bodystore.h
 
 RESOURCES += \
     bradypod.qrc
@@ -97,6 +127,11 @@ win32-msvc* {
     LIBS += -licudt
 }
 
+unix {
+    SOURCES += supervisor.cpp
+    HEADERS += supervisor.h
+}
+
 linux {
     # include($$PWD/qt-qpa-platform-plugin/bradypod-qpa.pri)
 
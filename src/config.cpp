@@ -8,11 +8,13 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QCoreApplication>
+#include <QRegularExpression>
 
 #include "terminal.h"
 #include "qcommandline.h"
 #include "utils.h"
 #include "consts.h"
+#include "domtags.h"
 
 
 static const struct QCommandLineConfigEntry flags[] = {
@@ -25,7 +27,7 @@ static const struct QCommandLineConfigEntry flags[] = {
     { QCommandLine::Option, '\0', "header", QStringLiteral("额外的请求头条目,如'--header=Referer:\\ abc'。该选项可以使用多次"), QCommandLine::Flags(QCommandLine::Optional | QCommandLine::Multiple) },
     { QCommandLine::Option, '\0', "user-agent", QStringLiteral("User Agent"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "headers-attach-to-per-request", QStringLiteral("自定义的请求头附加到每一个http请求上,'true'或'false'(默认)"), QCommandLine::Optional },
-    { QCommandLine::Option, '\0', "block-ip-and-domain", QStringLiteral("排除的域名或ip地址,允许通配符,如:*.example.com;*.gov"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "block-ip-and-domain", QStringLiteral("排除的域名或ip地址,允许通配符和CIDR网段,如:*.example.com;*.gov;10.0.0.0/8"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "config", QStringLiteral("指定JSON格式的配置文件"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "debug", QStringLiteral("打印额外的警告和调试信息:'true'或'false'(默认)"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "disk-cache", QStringLiteral("启用磁盘缓存:'true'或'false'(默认)"), QCommandLine::Optional },
@@ -57,6 +59,52 @@ static const struct QCommandLineConfigEntry flags[] = {
     { QCommandLine::Option, '\0', "ssl-client-certificate-file", QStringLiteral("设置客户端证书的位置"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "ssl-client-key-file", QStringLiteral("设置客户端私钥的位置"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "ssl-client-key-passphrase", QStringLiteral("设置客户端私钥的密码"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "url-list", QStringLiteral("从文件中逐行读取URL并在同一进程中依次加载,'-'表示从标准输入读取"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "concurrency", QStringLiteral("批量模式下同时加载的页面数,默认为1"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "workers", QStringLiteral("批量模式下预先fork的工作进程数,0(默认)表示不使用工作进程,仅支持Unix,不能与--crawl-depth,--checkpoint,--resume,--seen-file,--serve同时使用"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "worker-timeout", QStringLiteral("工作进程处理单个URL的最长时间,超时则结束并重启该进程,值:120(默认,单位:s),0表示不限制"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "serve", QStringLiteral("常驻服务模式,在Unix套接字路径或本机端口上接收JSON任务(每行一个)并逐行返回结果"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "crawl-depth", QStringLiteral("从起始URL出发跟随页面中发现的链接继续爬取的最大层数,0(默认)表示不爬取"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "crawl-scope", QStringLiteral("爬取范围,'host'(默认,与起始URL同主机),'domain'(同域名)或'all'"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "crawl-include", QStringLiteral("只爬取匹配该正则表达式的URL"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "crawl-exclude", QStringLiteral("不爬取匹配该正则表达式的URL"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "crawl-max-pages", QStringLiteral("最多爬取的页面数,0(默认)表示不限制"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "seen-file", QStringLiteral("爬取时已访问URL的布隆过滤器文件,跨进程保留,再次爬取时跳过已访问的URL"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "seen-capacity", QStringLiteral("新建--seen-file时预计的URL数量,值:10000000(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "max-host-connections", QStringLiteral("同一主机同时进行的请求数上限,0(默认)表示不限制"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "host-delay", QStringLiteral("同一主机两次请求开始之间的最小间隔,值:0(默认,单位:ms)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "host-bandwidth", QStringLiteral("同一主机的下载带宽上限(令牌桶),值:0(默认,不限制,单位:KB/s)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "checkpoint", QStringLiteral("批量/爬取模式下定期把待爬取队列,已访问URL,Cookie和输出文件位置保存到该目录"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "checkpoint-interval", QStringLiteral("保存检查点的间隔,值:60(默认,单位:s)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "resume", QStringLiteral("从该目录中最后一次保存的检查点继续执行,并继续在该目录保存检查点"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "page-max-loads", QStringLiteral("批量模式下每个页面复用加载的URL数,达到后销毁并重建该页面,值:200(默认),0表示不限制"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "page-max-memory", QStringLiteral("批量模式下进程常驻内存超过该值时重建刚完成加载的页面,值:0(默认,不限制,单位:MB)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "memory-soft-limit", QStringLiteral("进程常驻内存超过该值时清空WebKit内存缓存并逐步缩小对象缓存,值:0(默认,不限制,单位:MB)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "memory-hard-limit", QStringLiteral("进程常驻内存超过该值时中止正在加载的页面并输出'memory_limit'错误结果,值:0(默认,不限制,单位:MB)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "memory-check-interval", QStringLiteral("检查进程内存的间隔,值:1000(默认,单位:ms)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dom-skip-tags", QStringLiteral("解析DOM时跳过的标签及其子树,以逗号分隔,值:'svg,style'(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dom-max-depth", QStringLiteral("解析DOM的最大深度,值:512(默认),0表示不限制"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dom-max-nodes", QStringLiteral("每个页面最多解析的元素数,0(默认)表示不限制"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dom-tag-rules", QStringLiteral("调整标签分类,以逗号分隔,'标签:分类'把标签按该分类处理,'-分类'禁用该分类,分类:base,format,form,form_element,frame,image,media,hyperlink,list,table,section,meta,script,other,ignore"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "settle-quiet", QStringLiteral("模拟点击后页面没有DOM变化且没有进行中的XHR/fetch请求持续该时间即继续解析,值:20(默认,单位:ms)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "settle-timeout", QStringLiteral("模拟点击后等待页面稳定的最长时间,值:1000(默认,单位:ms)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "click-batch", QStringLiteral("模拟点击分批执行,同一批点击共享一次页面稳定等待,值:8(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dom-reparse-rounds", QStringLiteral("模拟点击后只重新解析新增或变化的DOM子树,直到没有新的点击或达到该轮数,0为不重新解析,值:5(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dom-xml", QStringLiteral("结果中记录的元素源码,'full'(默认)完整源码,'tag'只记录开始标签,'none'不记录,或数字:截断到该长度"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "frame-depth", QStringLiteral("解析已加载的子框架(iframe/frame)的最大嵌套深度,0为只解析主框架,值:2(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "url-scan", QStringLiteral("从页面源码(内联脚本/样式,srcset)和脚本/JSON/CSS响应内容中扫描URL和路径:'true'(默认)或'false'"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "form-replay", QStringLiteral("不经过WebKit直接提交发现的表单(默认值,下拉选项,单选/复选组合),每个表单最多提交的变体数,0为不提交,值:0(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "form-replay-timeout", QStringLiteral("等待表单提交响应的最长时间,值:5000(默认,单位:ms)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dns-ttl", QStringLiteral("检查block-domain时域名解析结果的缓存时间,所有页面共享,值:300(默认,单位:s)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "dns-negative-ttl", QStringLiteral("域名解析失败结果的缓存时间,值:30(默认,单位:s)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "block-resource", QStringLiteral("不加载的子资源类型:font,media,image,stylesheet,script或扩展名,如:font;media;.pdf"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "block-url", QStringLiteral("不加载的URL,允许通配符,如:*google-analytics.com/*;*/ads/*"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "response-body-types", QStringLiteral("完整保存响应内容的Content-Type,允许通配符,'none'为不保存,值:text/*;*json*;*javascript*;*ecmascript*;*xml*(默认)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "response-body-memory", QStringLiteral("单个响应内容保存在内存中的上限,超出部分写入临时文件,值:1024(默认,单位:KB)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "response-body-max-size", QStringLiteral("单个响应内容保存的上限,0为不限制,值:10240(默认,单位:KB)"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "response-body-dir", QStringLiteral("超出内存上限的响应内容的保存目录,未指定且未使用--body-store时超出部分不保存"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "body-store", QStringLiteral("按内容哈希(SHA-256)去重保存响应内容的目录,结果中以bodyRef引用,默认不启用"), QCommandLine::Optional },
+    { QCommandLine::Option, '\0', "body-store-compress", QStringLiteral("压缩body-store中保存的响应内容:'true'或'false'(默认)"), QCommandLine::Optional },
     { QCommandLine::Param, '\0', "url", QStringLiteral("需要解析的URL"), QCommandLine::Flags(QCommandLine::Optional | QCommandLine::ParameterFence)},
     { QCommandLine::Option, 'o', "output", QStringLiteral("将结果输出到文件"), QCommandLine::Optional },
     { QCommandLine::Option, '\0', "output-format", QStringLiteral("将结果以指定格式输出,'json' (默认值) 或'xml'"), QCommandLine::Optional },
@@ -97,6 +145,26 @@ void Config::init(const QStringList& args)
     if (!m_configFile.isEmpty()) {
         loadJsonFile(m_configFile);
     }
+
+    // every worker would run its own crawl and write the same checkpoint
+    // and seen file, the supervisor only knows the URLs it handed out
+    if (m_workers > 0 && m_unknownOption.isEmpty()) {
+        QString option;
+        if (m_crawlDepth > 0) {
+            option = "crawl-depth";
+        } else if (!m_checkpoint.isEmpty()) {
+            option = "checkpoint";
+        } else if (!m_resume.isEmpty()) {
+            option = "resume";
+        } else if (!m_seenFile.isEmpty()) {
+            option = "seen-file";
+        } else if (!m_serve.isEmpty()) {
+            option = "serve";
+        }
+        if (!option.isEmpty()) {
+            setUnknownOption(QString("The '%1' option can not be used with '--workers'.").arg(option));
+        }
+    }
 }
 
 void Config::processArgs(const QStringList& args)
@@ -250,32 +318,42 @@ void Config::setWaitAfterWindowOnload(const int millisecond)
 
 bool Config::isBlockedIpDomain(const QString& domain) const
 {
-    foreach (QRegExp wc, m_blockIpAndDomains) {
-        if (wc.exactMatch(domain))
-            return true;
-    }
-    return false;
+    return m_blockIpAndDomains.contains(domain);
 }
 
 bool Config::hasSetBlockDomain() const
 {
-    return m_blockIpAndDomains.length() > 0 ? true : false;
+    return !m_blockIpAndDomains.isEmpty();
 }
 
-QList<QRegExp> Config::blockedIpAndDomains() const
+bool Config::hasBlockedAddresses() const
 {
-    return m_blockIpAndDomains;
+    return m_blockIpAndDomains.hasAddressRules();
+}
+
+QStringList Config::blockedIpAndDomains() const
+{
+    return m_blockIpAndDomains.rules();
 }
 
 void Config::addBlockIpAndDomain(const QString& value)
 {
-    QString text = value.trimmed().toLower();
-    if (!text.isEmpty()) {
-        QRegExp wc = QRegExp(text,Qt::CaseInsensitive,QRegExp::Wildcard);
-        if (!m_blockIpAndDomains.contains(wc)) {
-            m_blockIpAndDomains.append(wc);
-        }
-    }
+    m_blockIpAndDomains.add(value);
+}
+
+const ResourceFilter& Config::resourceFilter() const
+{
+    return m_resourceFilter;
+}
+
+bool Config::addBlockResource(const QString& value)
+{
+    return value.trimmed().isEmpty() || m_resourceFilter.addType(value);
+}
+
+void Config::addBlockUrl(const QString& value)
+{
+    m_resourceFilter.addUrlPattern(value);
 }
 
 QString Config::configFile() const
@@ -591,6 +669,446 @@ void Config::setResourceUrl(const QString& value)
     m_resourceUrl = value;
 }
 
+QString Config::urlList() const
+{
+    return m_urlList;
+}
+
+void Config::setUrlList(const QString& value)
+{
+    m_urlList = value.trimmed();
+}
+
+int Config::concurrency() const
+{
+    return m_concurrency;
+}
+
+void Config::setConcurrency(const int value)
+{
+    m_concurrency = value > 0 ? value : 1;
+}
+
+int Config::workers() const
+{
+    return m_workers;
+}
+
+void Config::setWorkers(const int value)
+{
+    m_workers = value > 0 ? value : 0;
+}
+
+int Config::workerTimeout() const
+{
+    return m_workerTimeout;
+}
+
+void Config::setWorkerTimeout(const int value)
+{
+    m_workerTimeout = value > 0 ? value : 0;
+}
+
+QString Config::serve() const
+{
+    return m_serve;
+}
+
+void Config::setServe(const QString& value)
+{
+    m_serve = value.trimmed();
+}
+
+int Config::crawlDepth() const
+{
+    return m_crawlDepth;
+}
+
+void Config::setCrawlDepth(const int value)
+{
+    m_crawlDepth = value > 0 ? value : 0;
+}
+
+QString Config::crawlScope() const
+{
+    return m_crawlScope;
+}
+
+void Config::setCrawlScope(const QString& value)
+{
+    m_crawlScope = value.trimmed().toLower();
+}
+
+QString Config::crawlInclude() const
+{
+    return m_crawlInclude;
+}
+
+void Config::setCrawlInclude(const QString& value)
+{
+    m_crawlInclude = value;
+}
+
+QString Config::crawlExclude() const
+{
+    return m_crawlExclude;
+}
+
+void Config::setCrawlExclude(const QString& value)
+{
+    m_crawlExclude = value;
+}
+
+int Config::crawlMaxPages() const
+{
+    return m_crawlMaxPages;
+}
+
+void Config::setCrawlMaxPages(const int value)
+{
+    m_crawlMaxPages = value > 0 ? value : 0;
+}
+
+QString Config::seenFile() const
+{
+    return m_seenFile;
+}
+
+void Config::setSeenFile(const QString& value)
+{
+    m_seenFile = value.trimmed();
+}
+
+int Config::seenCapacity() const
+{
+    return m_seenCapacity;
+}
+
+void Config::setSeenCapacity(const int value)
+{
+    m_seenCapacity = value > 0 ? value : 10000000;
+}
+
+int Config::maxHostConnections() const
+{
+    return m_maxHostConnections;
+}
+
+void Config::setMaxHostConnections(const int value)
+{
+    m_maxHostConnections = value > 0 ? value : 0;
+}
+
+int Config::hostDelay() const
+{
+    return m_hostDelay;
+}
+
+void Config::setHostDelay(const int value)
+{
+    m_hostDelay = value > 0 ? value : 0;
+}
+
+int Config::hostBandwidth() const
+{
+    return m_hostBandwidth;
+}
+
+void Config::setHostBandwidth(const int value)
+{
+    m_hostBandwidth = value > 0 ? value : 0;
+}
+
+QString Config::checkpoint() const
+{
+    return m_checkpoint;
+}
+
+void Config::setCheckpoint(const QString& value)
+{
+    m_checkpoint = value.trimmed();
+}
+
+int Config::checkpointInterval() const
+{
+    return m_checkpointInterval;
+}
+
+void Config::setCheckpointInterval(const int value)
+{
+    m_checkpointInterval = value > 0 ? value : 60;
+}
+
+QString Config::resume() const
+{
+    return m_resume;
+}
+
+void Config::setResume(const QString& value)
+{
+    m_resume = value.trimmed();
+}
+
+int Config::pageMaxLoads() const
+{
+    return m_pageMaxLoads;
+}
+
+void Config::setPageMaxLoads(const int value)
+{
+    m_pageMaxLoads = value > 0 ? value : 0;
+}
+
+int Config::pageMaxMemory() const
+{
+    return m_pageMaxMemory;
+}
+
+void Config::setPageMaxMemory(const int value)
+{
+    m_pageMaxMemory = value > 0 ? value : 0;
+}
+
+int Config::memorySoftLimit() const
+{
+    return m_memorySoftLimit;
+}
+
+void Config::setMemorySoftLimit(const int value)
+{
+    m_memorySoftLimit = value > 0 ? value : 0;
+}
+
+int Config::memoryHardLimit() const
+{
+    return m_memoryHardLimit;
+}
+
+void Config::setMemoryHardLimit(const int value)
+{
+    m_memoryHardLimit = value > 0 ? value : 0;
+}
+
+int Config::memoryCheckInterval() const
+{
+    return m_memoryCheckInterval;
+}
+
+void Config::setMemoryCheckInterval(const int value)
+{
+    m_memoryCheckInterval = value > 0 ? value : 1000;
+}
+
+QString Config::domSkipTags() const
+{
+    return m_domSkipTags;
+}
+
+void Config::setDomSkipTags(const QString& value)
+{
+    m_domSkipTags = value.trimmed().toLower();
+}
+
+int Config::domMaxDepth() const
+{
+    return m_domMaxDepth;
+}
+
+void Config::setDomMaxDepth(const int value)
+{
+    m_domMaxDepth = value > 0 ? value : 0;
+}
+
+int Config::domMaxNodes() const
+{
+    return m_domMaxNodes;
+}
+
+void Config::setDomMaxNodes(const int value)
+{
+    m_domMaxNodes = value > 0 ? value : 0;
+}
+
+QString Config::domTagRules() const
+{
+    return m_domTagRules;
+}
+
+void Config::setDomTagRules(const QString& value)
+{
+    m_domTagRules = value.trimmed();
+}
+
+int Config::settleQuiet() const
+{
+    return m_settleQuiet;
+}
+
+void Config::setSettleQuiet(const int value)
+{
+    m_settleQuiet = value > 0 ? value : 0;
+}
+
+int Config::settleTimeout() const
+{
+    return m_settleTimeout;
+}
+
+void Config::setSettleTimeout(const int value)
+{
+    m_settleTimeout = value > 0 ? value : 0;
+}
+
+int Config::clickBatch() const
+{
+    return m_clickBatch;
+}
+
+void Config::setClickBatch(const int value)
+{
+    m_clickBatch = value > 0 ? value : 1;
+}
+
+int Config::domReparseRounds() const
+{
+    return m_domReparseRounds;
+}
+
+void Config::setDomReparseRounds(const int value)
+{
+    m_domReparseRounds = value > 0 ? value : 0;
+}
+
+QString Config::domXml() const
+{
+    return m_domXml;
+}
+
+void Config::setDomXml(const QString& value)
+{
+    m_domXml = value.trimmed().toLower();
+}
+
+int Config::frameDepth() const
+{
+    return m_frameDepth;
+}
+
+void Config::setFrameDepth(const int value)
+{
+    m_frameDepth = value > 0 ? value : 0;
+}
+
+bool Config::urlScan() const
+{
+    return m_urlScan;
+}
+
+void Config::setUrlScan(const bool value)
+{
+    m_urlScan = value;
+}
+
+int Config::formReplay() const
+{
+    return m_formReplay;
+}
+
+void Config::setFormReplay(const int value)
+{
+    m_formReplay = value > 0 ? value : 0;
+}
+
+int Config::formReplayTimeout() const
+{
+    return m_formReplayTimeout;
+}
+
+void Config::setFormReplayTimeout(const int value)
+{
+    m_formReplayTimeout = value > 0 ? value : 0;
+}
+
+int Config::dnsTtl() const
+{
+    return m_dnsTtl;
+}
+
+void Config::setDnsTtl(const int value)
+{
+    m_dnsTtl = value > 0 ? value : 0;
+}
+
+int Config::dnsNegativeTtl() const
+{
+    return m_dnsNegativeTtl;
+}
+
+void Config::setDnsNegativeTtl(const int value)
+{
+    m_dnsNegativeTtl = value > 0 ? value : 0;
+}
+
+QString Config::responseBodyTypes() const
+{
+    return m_responseBodyTypes;
+}
+
+void Config::setResponseBodyTypes(const QString& value)
+{
+    m_responseBodyTypes = value;
+}
+
+int Config::responseBodyMemory() const
+{
+    return m_responseBodyMemory;
+}
+
+void Config::setResponseBodyMemory(const int value)
+{
+    m_responseBodyMemory = value > 0 ? value : 0;
+}
+
+int Config::responseBodyMaxSize() const
+{
+    return m_responseBodyMaxSize;
+}
+
+void Config::setResponseBodyMaxSize(const int value)
+{
+    m_responseBodyMaxSize = value > 0 ? value : 0;
+}
+
+QString Config::responseBodyDir() const
+{
+    return m_responseBodyDir;
+}
+
+void Config::setResponseBodyDir(const QString& value)
+{
+    m_responseBodyDir = value;
+}
+
+QString Config::bodyStore() const
+{
+    return m_bodyStore;
+}
+
+void Config::setBodyStore(const QString& value)
+{
+    m_bodyStore = value;
+}
+
+bool Config::bodyStoreCompress() const
+{
+    return m_bodyStoreCompress;
+}
+
+void Config::setBodyStoreCompress(const bool value)
+{
+    m_bodyStoreCompress = value;
+}
+
 QString Config::userAgent() const
 {
     return m_userAgent;
@@ -728,6 +1246,7 @@ void Config::resetToDefaults()
 #endif
     m_only_load_first_request = false;
     m_blockIpAndDomains.clear();
+    m_resourceFilter = ResourceFilter();
     m_configFile = QString();
     m_cookiejar.clear();
     m_cookiesFile = QString();
@@ -763,6 +1282,50 @@ void Config::resetToDefaults()
 
     m_scriptLanguage.clear();
     m_resourceUrl.clear();
+    m_urlList.clear();
+    m_concurrency = 1;
+    m_workers = 0;
+    m_workerTimeout = 120;
+    m_serve.clear();
+    m_crawlDepth = 0;
+    m_crawlScope = "host";
+    m_crawlInclude.clear();
+    m_crawlExclude.clear();
+    m_crawlMaxPages = 0;
+    m_seenFile.clear();
+    m_seenCapacity = 10000000;
+    m_maxHostConnections = 0;
+    m_hostDelay = 0;
+    m_hostBandwidth = 0;
+    m_checkpoint.clear();
+    m_checkpointInterval = 60;
+    m_resume.clear();
+    m_pageMaxLoads = 200;
+    m_pageMaxMemory = 0;
+    m_memorySoftLimit = 0;
+    m_memoryHardLimit = 0;
+    m_memoryCheckInterval = 1000;
+    m_domSkipTags = "svg,style";
+    m_domMaxDepth = 512;
+    m_domMaxNodes = 0;
+    m_domTagRules.clear();
+    m_settleQuiet = 20;
+    m_settleTimeout = 1000;
+    m_clickBatch = 8;
+    m_domReparseRounds = 5;
+    m_domXml = "full";
+    m_frameDepth = 2;
+    m_urlScan = true;
+    m_formReplay = 0;
+    m_formReplayTimeout = 5000;
+    m_dnsTtl = 300;
+    m_dnsNegativeTtl = 30;
+    m_responseBodyTypes = "text/*;*json*;*javascript*;*ecmascript*;*xml*";
+    m_responseBodyMemory = 1024;
+    m_responseBodyMaxSize = 10240;
+    m_responseBodyDir.clear();
+    m_bodyStore.clear();
+    m_bodyStoreCompress = false;
     m_userAgent = "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/538.1 (KHTML, like Gecko) Bradypod/1 Safari/538.1";
     m_unknownOption.clear();
     m_versionFlag = false;
@@ -871,6 +1434,8 @@ void Config::handleOption(const QString& option, const QVariant& value)
     booleanFlags << "web-security";
     booleanFlags << "javascript-enable";
     booleanFlags << "java-enable";
+    booleanFlags << "url-scan";
+    booleanFlags << "body-store-compress";
     if (booleanFlags.contains(option)) {
         if ((value != "true") && (value != "yes") && (value != "false") && (value != "no")) {
             setUnknownOption(QString("Invalid values for '%1' option.").arg(option));
@@ -881,6 +1446,114 @@ void Config::handleOption(const QString& option, const QVariant& value)
 
     if (option == "url") {
         setResourceUrl(value.toString());
+    } else if (option == "url-list") {
+        setUrlList(value.toString());
+    } else if (option == "concurrency") {
+        setConcurrency(value.toInt());
+    } else if (option == "workers") {
+        setWorkers(value.toInt());
+    } else if (option == "worker-timeout") {
+        setWorkerTimeout(value.toInt());
+    } else if (option == "serve") {
+        setServe(value.toString());
+    } else if (option == "crawl-depth") {
+        setCrawlDepth(value.toInt());
+    } else if (option == "crawl-scope") {
+        QString scope = value.toString().trimmed().toLower();
+        if (scope != "host" && scope != "domain" && scope != "all") {
+            setUnknownOption(QString("Invalid values for '%1' option.").arg(option));
+            return;
+        }
+        setCrawlScope(scope);
+    } else if (option == "crawl-include" || option == "crawl-exclude") {
+        if (!QRegularExpression(value.toString()).isValid()) {
+            setUnknownOption(QString("Invalid values for '%1' option.").arg(option));
+            return;
+        }
+        if (option == "crawl-include") {
+            setCrawlInclude(value.toString());
+        } else {
+            setCrawlExclude(value.toString());
+        }
+    } else if (option == "crawl-max-pages") {
+        setCrawlMaxPages(value.toInt());
+    } else if (option == "seen-file") {
+        setSeenFile(value.toString());
+    } else if (option == "seen-capacity") {
+        setSeenCapacity(value.toInt());
+    } else if (option == "max-host-connections") {
+        setMaxHostConnections(value.toInt());
+    } else if (option == "host-delay") {
+        setHostDelay(value.toInt());
+    } else if (option == "host-bandwidth") {
+        setHostBandwidth(value.toInt());
+    } else if (option == "checkpoint") {
+        setCheckpoint(value.toString());
+    } else if (option == "checkpoint-interval") {
+        setCheckpointInterval(value.toInt());
+    } else if (option == "resume") {
+        setResume(value.toString());
+    } else if (option == "page-max-loads") {
+        setPageMaxLoads(value.toInt());
+    } else if (option == "page-max-memory") {
+        setPageMaxMemory(value.toInt());
+    } else if (option == "memory-soft-limit") {
+        setMemorySoftLimit(value.toInt());
+    } else if (option == "memory-hard-limit") {
+        setMemoryHardLimit(value.toInt());
+    } else if (option == "memory-check-interval") {
+        setMemoryCheckInterval(value.toInt());
+    } else if (option == "dom-skip-tags") {
+        setDomSkipTags(value.toString());
+    } else if (option == "dom-max-depth") {
+        setDomMaxDepth(value.toInt());
+    } else if (option == "dom-max-nodes") {
+        setDomMaxNodes(value.toInt());
+    } else if (option == "dom-tag-rules") {
+        if (!DOMTags().setRules(value.toString())) {
+            setUnknownOption(QString("Invalid values for '%1' option.").arg(option));
+            return;
+        }
+        setDomTagRules(value.toString());
+    } else if (option == "settle-quiet") {
+        setSettleQuiet(value.toInt());
+    } else if (option == "settle-timeout") {
+        setSettleTimeout(value.toInt());
+    } else if (option == "click-batch") {
+        setClickBatch(value.toInt());
+    } else if (option == "dom-reparse-rounds") {
+        setDomReparseRounds(value.toInt());
+    } else if (option == "dom-xml") {
+        QString mode = value.toString().trimmed().toLower();
+        if (mode != "none" && mode != "tag" && mode != "full" && mode.toInt() <= 0) {
+            setUnknownOption(QString("Invalid values for '%1' option.").arg(option));
+            return;
+        }
+        setDomXml(mode);
+    } else if (option == "frame-depth") {
+        setFrameDepth(value.toInt());
+    } else if (option == "url-scan") {
+        setUrlScan(boolValue);
+    } else if (option == "form-replay") {
+        setFormReplay(value.toInt());
+    } else if (option == "form-replay-timeout") {
+        setFormReplayTimeout(value.toInt());
+    } else if (option == "dns-ttl") {
+        setDnsTtl(value.toInt());
+    } else if (option == "dns-negative-ttl") {
+        setDnsNegativeTtl(value.toInt());
+    } else if (option == "response-body-types") {
+        setResponseBodyTypes(value.toString());
+    } else if (option == "response-body-memory") {
+        setResponseBodyMemory(value.toInt());
+    } else if (option == "response-body-max-size") {
+        setResponseBodyMaxSize(value.toInt());
+    } else if (option == "response-body-dir") {
+        setResponseBodyDir(value.toString());
+    } else if (option == "body-store") {
+        setBodyStore(value.toString());
+    } else if (option == "body-store-compress") {
+        setBodyStoreCompress(boolValue);
     } else if (option == "method") {
         setMethod(value.toString());
     } else if (option == "body") {
@@ -907,6 +1580,17 @@ void Config::handleOption(const QString& option, const QVariant& value)
         foreach (QString dominIP, domainIPs) {
             addBlockIpAndDomain(dominIP);
         }
+    } else if (option == "block-resource") {
+        foreach (QString resource, value.toString().split(QRegExp("[;,]"))) {
+            if (!addBlockResource(resource)) {
+                setUnknownOption(QString("Invalid values for '%1' option.").arg(option));
+                return;
+            }
+        }
+    } else if (option == "block-url") {
+        foreach (QString pattern, value.toString().split(";")) {
+            addBlockUrl(pattern);
+        }
     } else if (option == "config") {
         setConfigFile(value.toString());
     } else if (option == "debug") {
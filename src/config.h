@@ -5,6 +5,9 @@
 #include <QVariant>
 #include <QRegExp>
 
+#include "blocklist.h"
+#include "resourcefilter.h"
+
 class QCommandLine;
 
 class Config: public QObject
@@ -23,6 +26,50 @@ class Config: public QObject
     Q_PROPERTY(QString outputEncoding READ outputEncoding WRITE setOutputEncoding)
     Q_PROPERTY(QString outputFile READ outputFile WRITE setOutputFile)
     Q_PROPERTY(QString outputFormat READ outputFormat WRITE setOutputFormat)
+    Q_PROPERTY(QString urlList READ urlList WRITE setUrlList)
+    Q_PROPERTY(int concurrency READ concurrency WRITE setConcurrency)
+    Q_PROPERTY(int workers READ workers WRITE setWorkers)
+    Q_PROPERTY(int workerTimeout READ workerTimeout WRITE setWorkerTimeout)
+    Q_PROPERTY(QString serve READ serve WRITE setServe)
+    Q_PROPERTY(int crawlDepth READ crawlDepth WRITE setCrawlDepth)
+    Q_PROPERTY(QString crawlScope READ crawlScope WRITE setCrawlScope)
+    Q_PROPERTY(QString crawlInclude READ crawlInclude WRITE setCrawlInclude)
+    Q_PROPERTY(QString crawlExclude READ crawlExclude WRITE setCrawlExclude)
+    Q_PROPERTY(int crawlMaxPages READ crawlMaxPages WRITE setCrawlMaxPages)
+    Q_PROPERTY(QString seenFile READ seenFile WRITE setSeenFile)
+    Q_PROPERTY(int seenCapacity READ seenCapacity WRITE setSeenCapacity)
+    Q_PROPERTY(int maxHostConnections READ maxHostConnections WRITE setMaxHostConnections)
+    Q_PROPERTY(int hostDelay READ hostDelay WRITE setHostDelay)
+    Q_PROPERTY(int hostBandwidth READ hostBandwidth WRITE setHostBandwidth)
+    Q_PROPERTY(QString checkpoint READ checkpoint WRITE setCheckpoint)
+    Q_PROPERTY(int checkpointInterval READ checkpointInterval WRITE setCheckpointInterval)
+    Q_PROPERTY(QString resume READ resume WRITE setResume)
+    Q_PROPERTY(int pageMaxLoads READ pageMaxLoads WRITE setPageMaxLoads)
+    Q_PROPERTY(int pageMaxMemory READ pageMaxMemory WRITE setPageMaxMemory)
+    Q_PROPERTY(int memorySoftLimit READ memorySoftLimit WRITE setMemorySoftLimit)
+    Q_PROPERTY(int memoryHardLimit READ memoryHardLimit WRITE setMemoryHardLimit)
+    Q_PROPERTY(int memoryCheckInterval READ memoryCheckInterval WRITE setMemoryCheckInterval)
+    Q_PROPERTY(QString domSkipTags READ domSkipTags WRITE setDomSkipTags)
+    Q_PROPERTY(int domMaxDepth READ domMaxDepth WRITE setDomMaxDepth)
+    Q_PROPERTY(int domMaxNodes READ domMaxNodes WRITE setDomMaxNodes)
+    Q_PROPERTY(QString domTagRules READ domTagRules WRITE setDomTagRules)
+    Q_PROPERTY(int settleQuiet READ settleQuiet WRITE setSettleQuiet)
+    Q_PROPERTY(int settleTimeout READ settleTimeout WRITE setSettleTimeout)
+    Q_PROPERTY(int clickBatch READ clickBatch WRITE setClickBatch)
+    Q_PROPERTY(int domReparseRounds READ domReparseRounds WRITE setDomReparseRounds)
+    Q_PROPERTY(QString domXml READ domXml WRITE setDomXml)
+    Q_PROPERTY(int frameDepth READ frameDepth WRITE setFrameDepth)
+    Q_PROPERTY(bool urlScan READ urlScan WRITE setUrlScan)
+    Q_PROPERTY(int formReplay READ formReplay WRITE setFormReplay)
+    Q_PROPERTY(int formReplayTimeout READ formReplayTimeout WRITE setFormReplayTimeout)
+    Q_PROPERTY(int dnsTtl READ dnsTtl WRITE setDnsTtl)
+    Q_PROPERTY(int dnsNegativeTtl READ dnsNegativeTtl WRITE setDnsNegativeTtl)
+    Q_PROPERTY(QString responseBodyTypes READ responseBodyTypes WRITE setResponseBodyTypes)
+    Q_PROPERTY(int responseBodyMemory READ responseBodyMemory WRITE setResponseBodyMemory)
+    Q_PROPERTY(int responseBodyMaxSize READ responseBodyMaxSize WRITE setResponseBodyMaxSize)
+    Q_PROPERTY(QString responseBodyDir READ responseBodyDir WRITE setResponseBodyDir)
+    Q_PROPERTY(QString bodyStore READ bodyStore WRITE setBodyStore)
+    Q_PROPERTY(bool bodyStoreCompress READ bodyStoreCompress WRITE setBodyStoreCompress)
     Q_PROPERTY(QString proxyType READ proxyType WRITE setProxyType)
     Q_PROPERTY(QString proxy READ proxy WRITE setProxy)
     Q_PROPERTY(QString proxyAuth READ proxyAuth WRITE setProxyAuth)
@@ -79,9 +126,14 @@ public:
 
     bool isBlockedIpDomain(const QString& domain) const;
     bool hasSetBlockDomain() const;
-    QList<QRegExp> blockedIpAndDomains() const;
+    bool hasBlockedAddresses() const;
+    QStringList blockedIpAndDomains() const;
     void addBlockIpAndDomain(const QString& value);
 
+    const ResourceFilter& resourceFilter() const;
+    bool addBlockResource(const QString& value);
+    void addBlockUrl(const QString& value);
+
     QString configFile() const;
     void setConfigFile(const QString& value);
 
@@ -163,6 +215,138 @@ public:
     QString resourceUrl() const;
     void setResourceUrl(const QString& value);
 
+    QString urlList() const;
+    void setUrlList(const QString& value);
+
+    int concurrency() const;
+    void setConcurrency(const int value);
+
+    int workers() const;
+    void setWorkers(const int value);
+
+    int workerTimeout() const;
+    void setWorkerTimeout(const int value);
+
+    QString serve() const;
+    void setServe(const QString& value);
+
+    int crawlDepth() const;
+    void setCrawlDepth(const int value);
+
+    QString crawlScope() const;
+    void setCrawlScope(const QString& value);
+
+    QString crawlInclude() const;
+    void setCrawlInclude(const QString& value);
+
+    QString crawlExclude() const;
+    void setCrawlExclude(const QString& value);
+
+    int crawlMaxPages() const;
+    void setCrawlMaxPages(const int value);
+
+    QString seenFile() const;
+    void setSeenFile(const QString& value);
+
+    int seenCapacity() const;
+    void setSeenCapacity(const int value);
+
+    int maxHostConnections() const;
+    void setMaxHostConnections(const int value);
+
+    int hostDelay() const;
+    void setHostDelay(const int value);
+
+    int hostBandwidth() const;
+    void setHostBandwidth(const int value);
+
+    QString checkpoint() const;
+    void setCheckpoint(const QString& value);
+
+    int checkpointInterval() const;
+    void setCheckpointInterval(const int value);
+
+    QString resume() const;
+    void setResume(const QString& value);
+
+    int pageMaxLoads() const;
+    void setPageMaxLoads(const int value);
+
+    int pageMaxMemory() const;
+    void setPageMaxMemory(const int value);
+
+    int memorySoftLimit() const;
+    void setMemorySoftLimit(const int value);
+
+    int memoryHardLimit() const;
+    void setMemoryHardLimit(const int value);
+
+    int memoryCheckInterval() const;
+    void setMemoryCheckInterval(const int value);
+
+    QString domSkipTags() const;
+    void setDomSkipTags(const QString& value);
+
+    int domMaxDepth() const;
+    void setDomMaxDepth(const int value);
+
+    int domMaxNodes() const;
+    void setDomMaxNodes(const int value);
+
+    QString domTagRules() const;
+    void setDomTagRules(const QString& value);
+
+    int settleQuiet() const;
+    void setSettleQuiet(const int value);
+
+    int settleTimeout() const;
+    void setSettleTimeout(const int value);
+
+    int clickBatch() const;
+    void setClickBatch(const int value);
+
+    int domReparseRounds() const;
+    void setDomReparseRounds(const int value);
+
+    QString domXml() const;
+    void setDomXml(const QString& value);
+
+    int frameDepth() const;
+    void setFrameDepth(const int value);
+
+    bool urlScan() const;
+    void setUrlScan(const bool value);
+
+    int formReplay() const;
+    void setFormReplay(const int value);
+
+    int formReplayTimeout() const;
+    void setFormReplayTimeout(const int value);
+
+    int dnsTtl() const;
+    void setDnsTtl(const int value);
+
+    int dnsNegativeTtl() const;
+    void setDnsNegativeTtl(const int value);
+
+    QString responseBodyTypes() const;
+    void setResponseBodyTypes(const QString& value);
+
+    int responseBodyMemory() const;
+    void setResponseBodyMemory(const int value);
+
+    int responseBodyMaxSize() const;
+    void setResponseBodyMaxSize(const int value);
+
+    QString responseBodyDir() const;
+    void setResponseBodyDir(const QString& value);
+
+    QString bodyStore() const;
+    void setBodyStore(const QString& value);
+
+    bool bodyStoreCompress() const;
+    void setBodyStoreCompress(const bool value);
+
     QString userAgent() const;
     void setUserAgent(const QString& value);
 
@@ -236,7 +420,8 @@ private:
 
     QCommandLine* m_cmdLine;
     QVariantMap m_operation;
-    QList<QRegExp> m_blockIpAndDomains;
+    BlockList m_blockIpAndDomains;
+    ResourceFilter m_resourceFilter;
     bool m_autoLoadImages;
     QString m_renderImagePath;
     int m_waitAfterWindowOnload;
@@ -268,6 +453,50 @@ private:
     QString m_scriptEncoding;
     QString m_scriptLanguage;
     QString m_resourceUrl;
+    QString m_urlList;
+    int m_concurrency;
+    int m_workers;
+    int m_workerTimeout;
+    QString m_serve;
+    int m_crawlDepth;
+    QString m_crawlScope;
+    QString m_crawlInclude;
+    QString m_crawlExclude;
+    int m_crawlMaxPages;
+    QString m_seenFile;
+    int m_seenCapacity;
+    int m_maxHostConnections;
+    int m_hostDelay;
+    int m_hostBandwidth;
+    QString m_checkpoint;
+    int m_checkpointInterval;
+    QString m_resume;
+    int m_pageMaxLoads;
+    int m_pageMaxMemory;
+    int m_memorySoftLimit;
+    int m_memoryHardLimit;
+    int m_memoryCheckInterval;
+    QString m_domSkipTags;
+    int m_domMaxDepth;
+    int m_domMaxNodes;
+    QString m_domTagRules;
+    int m_settleQuiet;
+    int m_settleTimeout;
+    int m_clickBatch;
+    int m_domReparseRounds;
+    QString m_domXml;
+    int m_frameDepth;
+    bool m_urlScan;
+    int m_formReplay;
+    int m_formReplayTimeout;
+    int m_dnsTtl;
+    int m_dnsNegativeTtl;
+    QString m_responseBodyTypes;
+    int m_responseBodyMemory;
+    int m_responseBodyMaxSize;
+    QString m_responseBodyDir;
+    QString m_bodyStore;
+    bool m_bodyStoreCompress;
     QString m_userAgent;
     QString m_unknownOption;
     bool m_versionFlag;
@@ -0,0 +1,137 @@
+#include "dnscache.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHostAddress>
+#include <QHostInfo>
+
+// expired entries are dropped once the cache grows past this
+static const int DNS_CACHE_PURGE_SIZE = 4096;
+
+static DnsCache* dns_cache_instance = 0;
+
+DnsCache* DnsCache::instance()
+{
+    if (!dns_cache_instance) {
+        dns_cache_instance = new DnsCache(QCoreApplication::instance());
+    }
+    return dns_cache_instance;
+}
+
+DnsCache::DnsCache(QObject* parent)
+    : QObject(parent)
+    , m_ttl(300 * 1000)
+    , m_negativeTtl(30 * 1000)
+    , m_hits(0)
+    , m_negativeHits(0)
+    , m_lookupCount(0)
+    , m_failures(0)
+    , m_latency(0)
+    , m_maxLatency(0)
+    , m_heldRequests(0)
+    , m_heldTime(0)
+{
+}
+
+void DnsCache::setTtl(int ttl, int negativeTtl)
+{
+    m_ttl = qMax(0, ttl) * qint64(1000);
+    m_negativeTtl = qMax(0, negativeTtl) * qint64(1000);
+}
+
+bool DnsCache::lookup(const QString& host, QStringList* addresses)
+{
+    QHash<QString, Entry>::iterator entry = m_entries.find(host);
+    if (entry == m_entries.end()) {
+        return false;
+    }
+    bool failed = entry->addresses.isEmpty();
+    if (entry->stored.elapsed() >= (failed ? m_negativeTtl : m_ttl)) {
+        m_entries.erase(entry);
+        return false;
+    }
+    if (failed) {
+        m_negativeHits++;
+    } else {
+        m_hits++;
+    }
+    *addresses = entry->addresses;
+    return true;
+}
+
+void DnsCache::resolve(const QString& host)
+{
+    if (m_running.contains(host)) {
+        return;
+    }
+    m_lookupCount++;
+    m_running[host].start();
+    int id = QHostInfo::lookupHost(host, this, SLOT(onLookedUp(QHostInfo)));
+    m_lookups[id] = host;
+}
+
+void DnsCache::held(qint64 msec)
+{
+    m_heldRequests++;
+    m_heldTime += msec;
+}
+
+QVariantMap DnsCache::stats() const
+{
+    QVariantMap stats;
+    stats["hits"] = m_hits;
+    stats["negative_hits"] = m_negativeHits;
+    stats["lookups"] = m_lookupCount;
+    stats["failures"] = m_failures;
+    stats["running"] = m_running.size();
+    stats["cached"] = m_entries.size();
+    stats["latency"] = m_latency;
+    stats["latency_max"] = m_maxLatency;
+    stats["latency_avg"] = m_lookupCount > m_running.size() ? m_latency / (m_lookupCount - m_running.size()) : 0;
+    stats["held_requests"] = m_heldRequests;
+    stats["held_time"] = m_heldTime;
+    return stats;
+}
+
+// private slots:
+void DnsCache::onLookedUp(const QHostInfo& info)
+{
+    QString host = m_lookups.take(info.lookupId());
+    if (host.isEmpty()) {
+        return;
+    }
+    qint64 latency = m_running.take(host).elapsed();
+    m_latency += latency;
+    m_maxLatency = qMax(m_maxLatency, latency);
+
+    Entry entry;
+    if (info.error() == QHostInfo::NoError) {
+        foreach (const QHostAddress& address, info.addresses()) {
+            entry.addresses << address.toString();
+        }
+    }
+    if (entry.addresses.isEmpty()) {
+        m_failures++;
+        qDebug() << "DnsCache - lookup failed" << host << info.errorString();
+    }
+    entry.stored.start();
+
+    if (m_entries.size() >= DNS_CACHE_PURGE_SIZE) {
+        expire();
+    }
+    m_entries[host] = entry;
+
+    emit resolved(host, entry.addresses);
+}
+
+// private:
+void DnsCache::expire()
+{
+    QMutableHashIterator<QString, Entry> i(m_entries);
+    while (i.hasNext()) {
+        i.next();
+        if (i.value().stored.elapsed() >= (i.value().addresses.isEmpty() ? m_negativeTtl : m_ttl)) {
+            i.remove();
+        }
+    }
+}
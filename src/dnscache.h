@@ -0,0 +1,87 @@
+#ifndef DNSCACHE_H
+#define DNSCACHE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+#include <QVariantMap>
+
+class QHostInfo;
+
+/**
+ * Process wide cache of host name lookups for the block list check, shared
+ * by the network access managers of every page.
+ *
+ * Lookups run asynchronously (QHostInfo::lookupHost); a request to a host
+ * not in the cache is held by its ScheduledReply until resolved() is
+ * emitted, the event loop keeps running meanwhile. Concurrent requests to
+ * one host share a single lookup.
+ *
+ * QHostInfo does not report the record TTL, so answers are kept for
+ * '--dns-ttl' seconds and failed lookups (no address) for
+ * '--dns-negative-ttl' seconds.
+ */
+class DnsCache : public QObject
+{
+    Q_OBJECT
+public:
+    static DnsCache* instance();
+
+    void setTtl(int ttl, int negativeTtl);
+
+    /**
+     * @return true with the cached `addresses` of `host` (none after a
+     * failed lookup), false when it has to be resolved first
+     */
+    bool lookup(const QString& host, QStringList* addresses);
+
+    /**
+     * Start resolving `host` unless a lookup of it is running already.
+     */
+    void resolve(const QString& host);
+
+    /**
+     * A request waited `msec` ms for the lookup of its host.
+     */
+    void held(qint64 msec);
+
+    /**
+     * Counters since start: cache hits, lookups, failures, lookup latency
+     * and time requests were held, all in ms.
+     */
+    QVariantMap stats() const;
+
+signals:
+    void resolved(const QString& host, const QStringList& addresses);
+
+private slots:
+    void onLookedUp(const QHostInfo& info);
+
+private:
+    DnsCache(QObject* parent);
+
+    struct Entry {
+        QStringList addresses;
+        QElapsedTimer stored;
+    };
+
+    void expire();
+
+    qint64 m_ttl;
+    qint64 m_negativeTtl;
+    QHash<QString, Entry> m_entries;
+    QHash<int, QString> m_lookups;
+    QHash<QString, QElapsedTimer> m_running;
+
+    qint64 m_hits;
+    qint64 m_negativeHits;
+    qint64 m_lookupCount;
+    qint64 m_failures;
+    qint64 m_latency;
+    qint64 m_maxLatency;
+    qint64 m_heldRequests;
+    qint64 m_heldTime;
+};
+
+#endif // DNSCACHE_H
@@ -0,0 +1,218 @@
+// Link extractor of DOMParser, evaluated in the main frame in one call as
+// (<this file>)(options) with the DOMWalker options and the tags added by
+// '--dom-tag-rules':
+//   { skipTags: ['svg', ...], maxDepth: 0, maxNodes: 0, skipTextOnly: true,
+//     extraTags: { 'x-link': { properties: ['href'], clickable: true } },
+//     dirty: false }
+//
+// With dirty set only the elements recorded by domsettle.js since the last
+// call are walked: added subtrees, and elements whose attributes changed
+// (without their children), the whole document if the list overflowed.
+// Either way the dirty list is emptied.
+//
+// Walks the document inside JavaScriptCore and returns
+//   { nodes: [...], visited: <elements visited>, truncated: <a limit was hit> }
+// with one entry in nodes per element that can carry a URI:
+//   tag      tag name as reported by the DOM (upper case for HTML)
+//   urls     resolved values of the URL properties of the tag, in order
+//   type     'type' attribute
+//   method   'method' attribute
+//   onclick  (a link nav) an onclick handler is attached
+//   index    position in window.__bradypodNodes, to click it or read its
+//            markup (domxml.js) later
+//   clicked  (a link nav) reported by an earlier call already
+//   fields   (form) static form fields, name -> [ attributes ]
+//   content  (meta http-equiv=refresh) 'content' attribute
+(function (options) {
+    var URL_PROPERTIES = {
+        'form': ['action'],
+        'frame': ['src'], 'frameset': ['src'], 'noframes': ['src'], 'iframe': ['src'],
+        'img': ['src'], 'map': ['src'], 'area': ['href'], 'canvas': ['src'], 'figcaption': ['src'], 'figure': ['src'],
+        'audio': ['src'], 'source': ['src'], 'track': ['src'], 'video': ['src'],
+        'a': ['href'], 'link': ['href'], 'nav': ['href'],
+        'base': ['href'],
+        'script': ['src'], 'noscript': ['src'], 'embed': ['src'],
+        'applet': ['code', 'codebase', 'data', 'usemap'],
+        'object': ['archive', 'codebase', 'data', 'usemap']
+    };
+    var CLICKABLE = { 'a': true, 'link': true, 'nav': true };
+    var FORM_PARSE_TAGS = { 'input': true, 'textarea': true, 'button': true, 'select': true, 'optgroup': true,
+                            'option': true, 'output': true, 'datalist': true, 'keygen': true };
+    var FORM_SUBMIT_TAGS = { 'input': true, 'textarea': true, 'button': true, 'option': true };
+    var has = Object.prototype.hasOwnProperty;
+
+    for (var extra in options.extraTags) {
+        if (has.call(options.extraTags, extra)) {
+            URL_PROPERTIES[extra] = options.extraTags[extra].properties;
+            CLICKABLE[extra] = options.extraTags[extra].clickable;
+        }
+    }
+
+    function attribute(el, name) {
+        var value = el.getAttribute(name);
+        return value === null ? '' : value.trim();
+    }
+
+    function formFields(form) {
+        var result = {};
+        var stack = [{ el: form, name: '' }];
+        while (stack.length) {
+            var item = stack.pop();
+            var el = item.el;
+            var name = item.name;
+            var tag = el.tagName.toLowerCase();
+            if (el !== form && tag === 'form') {
+                continue;
+            }
+            if (has.call(FORM_PARSE_TAGS, tag) && el.hasAttribute('name')) {
+                name = tag === 'datalist' ? (el.getAttribute('id') || '') : el.getAttribute('name');
+            }
+            if (has.call(FORM_SUBMIT_TAGS, tag)) {
+                var attrs = {};
+                for (var i = 0; i < el.attributes.length; ++i) {
+                    attrs[el.attributes[i].name] = el.attributes[i].value;
+                }
+                attrs.tagName = el.tagName;
+                if (!el.hasAttribute('name')) {
+                    attrs.name = name;
+                }
+                if (!has.call(result, name)) {
+                    result[name] = [];
+                }
+                result[name].push(attrs);
+            }
+            // reversed, children are visited in document order
+            for (var child = el.lastElementChild; child; child = child.previousElementSibling) {
+                stack.push({ el: child, name: name });
+            }
+        }
+        return result;
+    }
+
+    function visit(el, tag) {
+        if (tag === 'meta') {
+            if (attribute(el, 'http-equiv').toLowerCase() === 'refresh') {
+                out.push({ tag: el.tagName, urls: [], type: attribute(el, 'type'), method: attribute(el, 'method'),
+                           index: nodes.length, content: attribute(el, 'content') });
+                nodes.push(el);
+            }
+            return;
+        }
+        if (!has.call(URL_PROPERTIES, tag)) {
+            return;
+        }
+
+        var urls = [];
+        var properties = URL_PROPERTIES[tag];
+        for (var p = 0; p < properties.length; ++p) {
+            var value = el[properties[p]];
+            urls.push(typeof value === 'string' ? value.trim() : '');
+        }
+
+        var node = { tag: el.tagName, urls: urls, type: attribute(el, 'type'), method: attribute(el, 'method'),
+                     index: nodes.length };
+        nodes.push(el);
+        if (CLICKABLE[tag] === true) {
+            node.onclick = el.onclick != null;
+            node.clicked = el.__bradypodClickable === true;
+            el.__bradypodClickable = true;
+        }
+        if (tag === 'form') {
+            node.fields = formFields(el);
+        }
+        out.push(node);
+    }
+
+    var skip = {};
+    for (var s = 0; s < options.skipTags.length; ++s) {
+        skip[options.skipTags[s]] = true;
+    }
+
+    // same walk as DOMWalker: explicit stack, document order, pruned
+    var nodes = window.__bradypodNodes = [];
+    var out = [];
+    var visited = 0;
+    var truncated = false;
+    var stack = [];
+    var depths = [];
+    var shallow = [];
+    var settle = window.__bradypodSettle;
+    var dirty = settle ? settle.dirty : [];
+    var overflow = settle ? settle.overflow : false;
+    if (settle) {
+        settle.dirty = [];
+        settle.overflow = false;
+    }
+    if (!options.dirty || overflow) {
+        if (document.documentElement) {
+            stack.push(document.documentElement);
+            depths.push(0);
+            shallow.push(false);
+        }
+    } else {
+        // a subtree root below another one, or no longer in the document,
+        // is dropped; reversed, roots are visited in mutation order
+        var mark = {};
+        for (var d = 0; d < dirty.length; ++d) {
+            if (!dirty[d].shallow) {
+                dirty[d].el.__bradypodDirty = mark;
+            }
+        }
+        for (d = dirty.length - 1; d >= 0; --d) {
+            var root = dirty[d].el;
+            if (root.__bradypodQueued === mark
+                    || !document.documentElement || !document.documentElement.contains(root)) {
+                continue;
+            }
+            var covered = false;
+            for (var up = dirty[d].shallow ? root : root.parentElement; up; up = up.parentElement) {
+                if (up.__bradypodDirty === mark) {
+                    covered = true;
+                    break;
+                }
+            }
+            if (!covered) {
+                stack.push(root);
+                depths.push(0);
+                shallow.push(dirty[d].shallow);
+                root.__bradypodQueued = mark;
+            }
+        }
+        for (d = 0; d < dirty.length; ++d) {
+            delete dirty[d].el.__bradypodDirty;
+            delete dirty[d].el.__bradypodQueued;
+        }
+    }
+    while (stack.length) {
+        var el = stack.pop();
+        var depth = depths.pop();
+        var leaf = shallow.pop();
+        var tag = el.tagName.toLowerCase();
+        if (has.call(skip, tag)) {
+            continue;
+        }
+        if (options.skipTextOnly && !el.firstElementChild && !el.hasAttributes()) {
+            continue;
+        }
+        if (options.maxNodes > 0 && visited >= options.maxNodes) {
+            truncated = true;
+            break;
+        }
+        visited++;
+        visit(el, tag);
+
+        if (leaf || !el.firstElementChild) {
+            continue;
+        }
+        if (options.maxDepth > 0 && depth >= options.maxDepth) {
+            truncated = true;
+            continue;
+        }
+        for (var child = el.lastElementChild; child; child = child.previousElementSibling) {
+            stack.push(child);
+            depths.push(depth + 1);
+            shallow.push(false);
+        }
+    }
+    return { nodes: out, visited: visited, truncated: truncated };
+})
@@ -1,11 +1,22 @@
 ﻿#include "domparser.h"
 #include "terminal.h"
+#include "utils.h"
+#include "bradypod.h"
+#include "config.h"
+#include "domtags.h"
+#include "urlscanner.h"
+#include "formreplay.h"
 
 #include <QDebug>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QEventLoop>
-#include <QCryptographicHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
 #include <QRegularExpression>
+#include <QWebSecurityOrigin>
 #include <QtWebKitWidgets>
 
 // webkit private api
@@ -15,153 +26,446 @@
 
 using namespace WebCore;
 
-static const QStringList tags_base = QStringLiteral("html title body h1 h2 h3 h4 h5 h6 p br hr")
-        .split(" ", QString::SkipEmptyParts);
-
-static const QStringList tags_format = QStringLiteral("acronym abbr address b bdi bdo big blockquote center cite code del dfn em font i ins kbd mark meter pre progress q rp rt ruby s samp small strike strong sup sub time tt u var wbr")
-        .split(" ", QString::SkipEmptyParts);
-
-static const QStringList tags_form = QStringLiteral("form").split(" ", QString::SkipEmptyParts);
-static const QStringList tags_form_element = QStringLiteral("input textarea button select optgroup option label fieldset legend isindex datalist keygen output").split(" ", QString::SkipEmptyParts);
+// URL properties read per tag, same table as URL_PROPERTIES in domextract.js
+static QStringList url_properties(const QString& tag, DOMTags::Category category)
+{
+    switch (category) {
+    case DOMTags::Form:
+        return QStringList() << "action";
+    case DOMTags::Frame:
+    case DOMTags::Media:
+        return QStringList() << "src";
+    case DOMTags::Image:
+        return QStringList() << (tag == "area" ? "href" : "src");
+    case DOMTags::Hyperlink:
+        return QStringList() << "href";
+    case DOMTags::Meta:
+        return tag == "base" ? QStringList() << "href" : QStringList();
+    case DOMTags::Script:
+        if (tag == "applet")
+            return QStringList() << "code" << "codebase" << "data" << "usemap";
+        if (tag == "object")
+            return QStringList() << "archive" << "codebase" << "data" << "usemap";
+        return tag == "param" ? QStringList() : QStringList() << "src";
+    default:
+        return QStringList();
+    }
+}
 
-static const QStringList tags_frame = QStringLiteral("frame frameset noframes iframe")
-        .split(" ", QString::SkipEmptyParts);
+static inline QString elide(const QString& str, int max_len = 300)
+{
+    return str.length() <= max_len ? str : str.left(150) + "  ...  " + str.right(150);
+}
 
-static const QStringList tags_image = QStringLiteral("img map area canvas figcaption figure")
-        .split(" ", QString::SkipEmptyParts);
 
-static const QStringList tags_media = QStringLiteral("audio source track video")
-        .split(" ", QString::SkipEmptyParts);
+#define printSimpleElement(element) qDebug()<<GREEN<<__FUNCTION__ <<" tag :: "<<element.tagName().trimmed()<<NONE<<" XML:: "<<elide(element.toOuterXml().trimmed())
+#define printSimpleNode(node) qDebug()<<GREEN<<__FUNCTION__ <<" tag :: "<<node.value("tag").toString()<<NONE<<" URLS:: "<<node.value("urls").toStringList()
 
-static const QStringList tags_hyperlink = QStringLiteral("a link nav")
-        .split(" ", QString::SkipEmptyParts);
 
-static const QStringList tags_list = QStringLiteral("ul ol li dir dl dt dd menu menuitem command")
-        .split(" ", QString::SkipEmptyParts);
+DOMParser::DOMParser(QObject *parent, WebPage* webpage) : QObject(parent)
+{
+    m_webpage = webpage;
+    m_webEelement = webpage->mainFrame()->documentElement();
 
-static const QStringList tags_table = QStringLiteral("table caption th tr td thead tbody tfoot col colgroup")
-        .split(" ", QString::SkipEmptyParts);
+    Config* config = Bradypod::instance()->config();
+    m_walkOptions.skipTags = config->domSkipTags().split(",", QString::SkipEmptyParts);
+    m_walkOptions.maxDepth = config->domMaxDepth();
+    m_walkOptions.maxNodes = config->domMaxNodes();
+    m_walkOptions.skipTextOnly = true;
+    m_tags.setRules(config->domTagRules());
+    m_settleQuiet = config->settleQuiet();
+    m_settleTimeout = config->settleTimeout();
+    m_clickBatch = config->clickBatch();
+    m_reparseRounds = config->domReparseRounds();
+    // none, tag, full or a length to truncate to
+    bool truncate = false;
+    m_xmlLimit = config->domXml().toInt(&truncate);
+    m_xmlMode = truncate ? "truncate" : config->domXml();
+    m_frame = webpage->mainFrame();
+    m_frameDepth = 0;
+    m_maxFrameDepth = config->frameDepth();
+    m_urlScan = config->urlScan();
+    m_formReplayVariants = config->formReplay();
+    m_formReplayTimeout = config->formReplayTimeout();
+    m_replay = new FormReplay(this, webpage);
+    connect(m_replay, SIGNAL(replayed(QVariant)), SIGNAL(parsedLinks(QVariant)));
+    connect(m_replay, SIGNAL(done()), SIGNAL(replayFinished()));
+}
 
-static const QStringList tags_section = QStringLiteral("style div span header footer section article aside details dialog summary details")
-        .split(" ", QString::SkipEmptyParts);
+// DOMWalker visitor of the C++ fallback: every element goes to parse_element
+class ParseVisitor : public DOMVisitor
+{
+public:
+    explicit ParseVisitor(DOMParser* parser) : m_parser(parser) {}
+
+    bool enter(const QWebElement& element, int depth)
+    {
+        (void)depth;
+        qDebug()<<YELLOW<<"_traversal_dom tag :: "<<element.tagName().trimmed()<<NONE;
+        QWebElement current = element;
+        m_parser->parse_element(current);
+        return true;
+    }
 
-static const QStringList tags_meta = QStringLiteral("head meta base basefont")
-        .split(" ", QString::SkipEmptyParts);
+private:
+    DOMParser* m_parser;
+};
 
-static const QStringList tags_script = QStringLiteral("script noscript applet embed object param")
-        .split(" ", QString::SkipEmptyParts);
+void DOMParser::_traversal_dom(QWebElement &element)
+{
+    ParseVisitor visitor(this);
+    DOMWalker walker(m_walkOptions);
+    int visited = walker.walk(element, &visitor);
+    qDebug()<<GREEN<<"VISITED_ELEMENTS::"<<visited<<(walker.truncated() ? "(truncated)" : "")<<NONE;
+}
 
-static inline QString elide(const QString& str, int max_len = 300)
+bool DOMParser::_extract_nodes(QVariantList& nodes, bool dirty)
 {
-    return str.length() <= max_len ? str : str.left(150) + "  ...  " + str.right(150);
+    static const QString script = Utils::readResourceFileUtf8(":/domextract.js");
+
+    QJsonObject options;
+    options["skipTags"] = QJsonArray::fromStringList(m_walkOptions.skipTags);
+    options["maxDepth"] = m_walkOptions.maxDepth;
+    options["maxNodes"] = m_walkOptions.maxNodes;
+    options["skipTextOnly"] = m_walkOptions.skipTextOnly;
+    // tags added by --dom-tag-rules
+    QJsonObject extraTags;
+    QHashIterator<QString, DOMTags::Category> i(m_tags.overrides());
+    while (i.hasNext()) {
+        i.next();
+        QJsonObject extra;
+        extra["properties"] = QJsonArray::fromStringList(url_properties(i.key(), i.value()));
+        extra["clickable"] = i.value() == DOMTags::Hyperlink;
+        extraTags[i.key()] = extra;
+    }
+    options["extraTags"] = extraTags;
+    options["dirty"] = dirty;
+    QString call = QString("(%1)(%2);").arg(script, QString::fromUtf8(QJsonDocument(options).toJson(QJsonDocument::Compact)));
+
+    QVariantMap result = m_frame->evaluateJavaScript(call).toMap();
+    if (!result.contains("nodes")) {
+        return false;
+    }
+    qDebug()<<GREEN<<"VISITED_ELEMENTS::"<<result.value("visited").toInt()
+            <<(result.value("truncated").toBool() ? "(truncated)" : "")<<NONE;
+    nodes = result.value("nodes").toList();
+    return true;
 }
 
+void DOMParser::parse_traversal_dom()
+{
+    qDebug()<<GREEN<<"BODY_LENGTH::"<<m_webpage->mainFrame()->toHtml().length()<<NONE<<"\n\n";
+//    qDebug()<<"document.readyState"<<m_webpage->mainFrame()->evaluateJavaScript("document.readyState;");
 
-#define printSimpleElement(element) qDebug()<<GREEN<<__FUNCTION__ <<" tag :: "<<element.tagName().trimmed()<<NONE<<" XML:: "<<elide(element.toOuterXml().trimmed())
+    m_frame = m_webpage->mainFrame();
+    m_frameDepth = 0;
+    parse_frame();
 
+    // frames loaded along with the page, parsed in place of a second load
+    parse_child_frames(m_webpage->mainFrame(), 1);
+    m_frame = m_webpage->mainFrame();
+    m_frameDepth = 0;
+}
 
-DOMParser::DOMParser(QObject *parent, WebPage* webpage) : QObject(parent)
+void DOMParser::parse_child_frames(QWebFrame* parent, int depth)
 {
-    m_webpage = webpage;
-    m_webEelement = webpage->mainFrame()->documentElement();
+    if (depth > m_maxFrameDepth) {
+        return;
+    }
+    // a frame can remove its siblings while it is parsed (clicks)
+    QList<QPointer<QWebFrame> > children;
+    foreach (QWebFrame* child, parent->childFrames()) {
+        children << child;
+    }
+    foreach (QPointer<QWebFrame> child, children) {
+        if (child.isNull() || child->documentElement().isNull()) {
+            continue;
+        }
+        qDebug()<<GREEN<<"FRAME::"<<child->url().toString()<<"depth:"<<depth<<NONE;
+        m_frame = child;
+        m_frameDepth = depth;
+        parse_frame();
+        if (!child.isNull()) {
+            parse_child_frames(child, depth + 1);
+        }
+    }
 }
 
-void DOMParser::_traversal_dom(QWebElement &element)
+void DOMParser::parse_frame()
 {
-    if (element.isNull()) {
-        return;
+    // watch mutations and XHR/fetch before anything is clicked
+    static const QString settle_script = Utils::readResourceFileUtf8(":/domsettle.js");
+    m_frame->evaluateJavaScript(settle_script);
+
+    // one call into the page collects every URI-carrying element
+    QVariantList nodes;
+    bool extracted = _extract_nodes(nodes);
+    if (extracted) {
+        qDebug()<<GREEN<<"EXTRACTED_NODES::"<<nodes.size()<<NONE;
+        foreach (const QVariant& node, nodes) {
+            parse_node(node.toMap());
+        }
     } else {
-        qDebug()<<YELLOW<<__FUNCTION__ <<" tag :: "<<element.tagName().trimmed()<<NONE;
-        // printSimpleElement(element);
-        // parse `element`
-        parse_element(element);
-        // child
-        QWebElement child = element.firstChild();
-        _traversal_dom(child);
-
-        // sibling
-        QWebElement sibling = child.nextSibling();
-        while(!sibling.isNull()) {
-            _traversal_dom(sibling);
-            sibling = sibling.nextSibling();
+        // script execution failed (e.g. JavaScript disabled), walk the DOM from C++
+        qDebug()<<RED<<"DOM extractor unavailable, traversing elements"<<NONE;
+        QWebElement element = m_frame->documentElement();
+        // parser start
+        _traversal_dom(element);
+    }
+
+    // URLs in inline scripts and styles, srcset, ...
+    scan_text(m_frame->toHtml().toUtf8(), m_frame->baseUrl(), "html");
+
+    // clicks queued by the tag handlers; links they insert are found by
+    // walking only the changed subtrees (the fallback has no mutation list)
+    bool clicked = !m_clicks.isEmpty();
+    run_clicks();
+
+    for (int round = 0; extracted && clicked && !m_frame.isNull() && round < m_reparseRounds; ++round) {
+        QVariantList dirty_nodes;
+        if (!_extract_nodes(dirty_nodes, true)) {
+            break;
+        }
+        qDebug()<<GREEN<<"REPARSE_ROUND::"<<round + 1<<"EXTRACTED_NODES::"<<dirty_nodes.size()<<NONE;
+        foreach (const QVariant& node, dirty_nodes) {
+            parse_node(node.toMap());
         }
+        clicked = !m_clicks.isEmpty();
+        run_clicks();
     }
+
+    replay_forms();
 }
 
-void DOMParser::parse_traversal_dom()
+void DOMParser::reset()
 {
-    qDebug()<<GREEN<<"BODY_LENGTH::"<<m_webpage->mainFrame()->toHtml().length()<<NONE<<"\n\n";
-    QWebElement element = m_webpage->mainFrame()->documentElement();
-//    qDebug()<<"document.readyState"<<m_webpage->mainFrame()->evaluateJavaScript("document.readyState;");
-    // parser start
-    _traversal_dom(element);
+    m_rescheduling.clear();
+    m_clicks.clear();
+    m_clickRequests.clear();
+    m_forms.clear();
+    m_frame = m_webpage->mainFrame();
+    m_frameDepth = 0;
+    m_webEelement = m_webpage->mainFrame()->documentElement();
 }
 
-void DOMParser::parse_element(QWebElement& element)
+static QVariantMap staticParserForm(QWebElement& element);
+
+QVariantMap DOMParser::element_node(QWebElement& element)
 {
+    QVariantMap node;
     QString tag = element.tagName().toLower();
-    if (tags_base.contains(tag))                // base
-        handle_tag_bases(element);
-    else if (tags_format.contains(tag))         // format
-        handle_tag_formats(element);
-    else if (tags_form.contains(tag))           // form
-        handle_tag_forms(element);
-    else if (tags_form_element.contains(tag))   // form element
-        (void)element;  // ignore
-    else if (tags_frame.contains(tag))          // frame
-        handle_tag_frames(element);
-    else if (tags_image.contains(tag))          // image
-        handle_tag_images(element);
-    else if (tags_media.contains(tag))          // media
-        handle_tag_media(element);
-    else if (tags_hyperlink.contains(tag))      // hyperlinks
-        handle_tag_hyperlinks(element);
-    else if (tags_list.contains(tag))           // list
-        handle_tag_list(element);
-    else if (tags_table.contains(tag))          // table
-        handle_tag_table(element);
-    else if (tags_section.contains(tag))        // section
-        handle_tag_sections(element);
-    else if (tags_meta.contains(tag))           // meta
-        handle_tag_meta(element);
-    else if (tags_script.contains(tag))         // script
-        handle_tag_script(element);
-    else                                        // other
-        handle_tag_other(element);
-}
-
-void DOMParser::emulate_click(QWebElement &element,QString jscode)
+    DOMTags::Category category = m_tags.classify(tag);
+    node["tag"] = element.tagName();
+    node["type"] = element.attribute("type").trimmed();
+    node["method"] = element.attribute("method").trimmed();
+    node["element"] = QVariant::fromValue(element);
+
+    if (tag == "meta" && element.attribute("http-equiv").toLower().trimmed() == "refresh") {
+        node["content"] = element.attribute("content").trimmed();
+    }
+
+    QStringList properties = url_properties(tag, category);
+    if (!properties.isEmpty()) {
+        QVariantList urls;
+        foreach (QString prop, properties) {
+            urls << element.evaluateJavaScript("this." + prop).toString().trimmed();
+        }
+        node["urls"] = urls;
+    }
+    if (category == DOMTags::Hyperlink) {
+        node["onclick"] = element.evaluateJavaScript("this.onclick == null ? \"false\" : \"true\"").toBool();
+    }
+    if (category == DOMTags::Form) {
+        node["fields"] = staticParserForm(element);
+    }
+    return node;
+}
+
+void DOMParser::parse_element(QWebElement& element)
+{
+    parse_node(element_node(element));
+}
+
+void DOMParser::parse_node(const QVariantMap& node)
+{
+    switch (m_tags.classify(node.value("tag").toString())) {
+    case DOMTags::Base:         handle_tag_bases(node);         break;
+    case DOMTags::Format:       handle_tag_formats(node);       break;
+    case DOMTags::Form:         handle_tag_forms(node);         break;
+    case DOMTags::FormElement:  /* ignore */                    break;
+    case DOMTags::Frame:        handle_tag_frames(node);        break;
+    case DOMTags::Image:        handle_tag_images(node);        break;
+    case DOMTags::Media:        handle_tag_media(node);         break;
+    case DOMTags::Hyperlink:    handle_tag_hyperlinks(node);    break;
+    case DOMTags::List:         handle_tag_list(node);          break;
+    case DOMTags::Table:        handle_tag_table(node);         break;
+    case DOMTags::Section:      handle_tag_sections(node);      break;
+    case DOMTags::Meta:         handle_tag_meta(node);          break;
+    case DOMTags::Script:       handle_tag_script(node);        break;
+    case DOMTags::Ignore:                                       break;
+    default:                    handle_tag_other(node);         break;
+    }
+}
+
+void DOMParser::emulate_click(const QVariantMap& node,QString jscode)
 {
     static long int count = 1;
 
     qDebug()<<RED<<"Special operation count: "<<NONE<< count++;
-//    printSimpleElement(element);
+//    printSimpleNode(node);
 
-    if (element.tagName().compare("form",Qt::CaseInsensitive) == 0 ) {
+    if (node.value("tag").toString().compare("form",Qt::CaseInsensitive) == 0 ) {
         // TODO: form click
-    } else {
-        element.evaluateJavaScript(jscode);
+    } else if (node.contains("element")) {
+        node.value("element").value<QWebElement>().evaluateJavaScript(jscode);
+    } else if (node.contains("index") && !m_frame.isNull()) {
+        // element kept by domextract.js, `this` is bound to it
+        m_frame->evaluateJavaScript(QString("(function () { %1 }).call(window.__bradypodNodes[%2]);")
+                                  .arg(jscode).arg(node.value("index").toInt()));
     }
 }
 
-static QByteArray toDigest(const QString& data)
+void DOMParser::queue_click(const QVariantMap& node)
 {
-    return QCryptographicHash::hash(data.toUtf8(), QCryptographicHash::Sha512).toHex();
+    // clicked in an earlier round, its subtree changed since
+    if (node.value("clicked").toBool()) {
+        return;
+    }
+    m_clicks.append(node);
 }
 
-void DOMParser::submit_uri(const QString& uri, const QWebElement& element, const QString& method, const QVariantMap& body)
+void DOMParser::set_click_tag(const QString& tag)
+{
+    m_clickTag = tag;
+    m_webpage->setRequestTag(tag.isEmpty() ? QVariant() : QVariant(tag));
+    if (m_frame.isNull()) {
+        return;
+    }
+    m_frame->evaluateJavaScript(QString("if (window.__bradypodSettle) window.__bradypodSettle.click = %1;")
+                              .arg(tag.isEmpty() ? QString("null") : "'" + tag + "'"));
+}
+
+void DOMParser::run_clicks()
+{
+    static long int count = 0;
+    // mutation counts per click id, reset for the next batch
+    static const QString mutations_js = "(function (s) {"
+            "  if (!s) return {};"
+            "  var m = s.mutations; s.mutations = {}; s.click = null; return m;"
+            "})(window.__bradypodSettle);";
+
+    if (m_clicks.isEmpty()) {
+        return;
+    }
+    connect(m_webpage, SIGNAL(resourceRequested(QVariant, QObject*)),
+            this, SLOT(on_resourceRequested(QVariant, QObject*)));
+    connect(m_webpage, SIGNAL(navigationRequested(QString, QString, bool, bool)),
+            this, SLOT(on_navigationRequested(QString, QString, bool, bool)));
+
+    while (!m_clicks.isEmpty()) {
+        QList<QVariantMap> batch = m_clicks.mid(0, m_clickBatch);
+        m_clicks = m_clicks.mid(batch.size());
+
+        // synchronous effects (handler, mutations delivered at the end of
+        // the click script) belong to the element clicked
+        QStringList ids;
+        foreach (const QVariantMap& node, batch) {
+            QString id = "dom_click_" + QString::number(++count);
+            ids << id;
+            set_click_tag(id);
+            emulate_click(node);
+        }
+        // later ones (timers, XHR callbacks) only to the batch
+        QString batch_id = ids.join(",");
+        set_click_tag(batch_id);
+        settle();
+        set_click_tag(QString());
+        if (m_frame.isNull()) {
+            qDebug()<<RED<<"frame removed while clicking, "<<m_clicks.size()<<" click(s) dropped"<<NONE;
+            m_clicks.clear();
+            m_clickRequests.clear();
+            break;
+        }
+        QVariantMap mutations = m_frame->evaluateJavaScript(mutations_js).toMap();
+
+        for (int i = 0; i < batch.size(); ++i) {
+            const QVariantMap& node = batch.at(i);
+            QVariantList requests = m_clickRequests.value(ids.at(i));
+            QVariantList batch_requests = m_clickRequests.value(batch_id);
+            int node_mutations = mutations.value(ids.at(i)).toInt();
+            int batch_mutations = mutations.value(batch_id).toInt();
+            if (requests.isEmpty() && batch_requests.isEmpty() && node_mutations == 0 && batch_mutations == 0) {
+                continue;
+            }
+
+            QVariantMap result;
+            result["id"] = ids.at(i);
+            result["type"] = "dom_click";
+            result["uri"] = node.value("urls").toList().value(0);
+            result["tag_name"] = node.value("tag");
+            if (m_xmlMode != "none") {
+                result["xml"] = node_xml(node).trimmed();
+            }
+            result["batch"] = ids;
+            result["requests"] = requests;
+            result["batch_requests"] = batch_requests;
+            result["mutations"] = node_mutations;
+            result["batch_mutations"] = batch_mutations;
+            tag_frame(result);
+            emit parsedLinks(result);
+        }
+        m_clickRequests.clear();
+    }
+
+    disconnect(m_webpage, SIGNAL(resourceRequested(QVariant, QObject*)),
+               this, SLOT(on_resourceRequested(QVariant, QObject*)));
+    disconnect(m_webpage, SIGNAL(navigationRequested(QString, QString, bool, bool)),
+               this, SLOT(on_navigationRequested(QString, QString, bool, bool)));
+}
+
+void DOMParser::on_resourceRequested(const QVariant& data, QObject* request)
+{
+    (void)request;
+    QVariantMap map = data.toMap();
+    QString initiator = map.value("initiator").toString();
+    if (initiator.isEmpty()) {
+        return;
+    }
+    QVariantMap entry;
+    entry["id"] = map.value("id");
+    entry["url"] = map.value("url");
+    entry["method"] = map.value("method");
+    if (map.contains("postData")) {
+        entry["postData"] = map.value("postData");
+    }
+    m_clickRequests[initiator].append(entry);
+}
+
+void DOMParser::on_navigationRequested(const QString& url, const QString& navigationType, bool navigationLocked, bool isMainFrame)
+{
+    (void)navigationLocked;
+    if (m_clickTag.isEmpty()) {
+        return;
+    }
+    QVariantMap entry;
+    entry["url"] = url;
+    entry["method"] = "GET";
+    entry["navigation"] = navigationType;
+    entry["main_frame"] = isMainFrame;
+    m_clickRequests[m_clickTag].append(entry);
+}
+
+void DOMParser::submit_uri(const QString& uri, const QVariantMap& node, const QString& method, const QVariantMap& body)
 {
     static long int count = 0;
     QVariantMap result;
-    QString submit_method = method.length() > 0 ? method : element.attribute("method").trimmed();
+    QString submit_method = method.length() > 0 ? method : node.value("method").toString();
     submit_method = submit_method.length() > 0 ? submit_method : "GET";
-    QString mime_type = element.attribute("type").trimmed();
-
-    QByteArray hash = toDigest(uri+"-method-"+method+"-mime_type-"+mime_type);
+    QString mime_type = node.value("type").toString();
 
-    if (!m_rescheduling.contains(hash)) {
-        m_rescheduling.insert(hash);
+    QString key = uri+"-method-"+method+"-mime_type-"+mime_type;
 
+    if (m_rescheduling.insert(key.toUtf8())) {
         count ++;
         result["id"] = "dom_parser_"+QString::number(count);
         result["type"] = "dom_parser";
@@ -171,19 +475,112 @@ void DOMParser::submit_uri(const QString& uri, const QWebElement& element, const
             result["body"] = body;
         }
         result["mime_type"] = mime_type;
-        result["tag_name"] = element.tagName();
-        result["xml"] = element.toOuterXml().trimmed();
+        result["tag_name"] = node.value("tag");
+        if (m_xmlMode != "none") {
+            result["xml"] = node_xml(node).trimmed();
+        }
+        tag_frame(result);
 
         emit parsedLinks(result);
     }
 }
 
+void DOMParser::scan_text(const QByteArray& text, const QUrl& base, const QString& source)
+{
+    static const int max_tokens = 10000;
+    static const QStringList schemes = QStringList()<<"http"<<"https"<<"ws"<<"wss"<<"ftp";
+
+    if (!m_urlScan) {
+        return;
+    }
+    QVariantMap node;
+    node["tag"] = "#" + source;
+    int found = 0;
+    foreach (QByteArray token, UrlScanner::scan(text, max_tokens)) {
+        if (source == "html") {
+            token.replace("&amp;", "&");
+        }
+        QUrl url = base.resolved(QUrl(QString::fromUtf8(token)));
+        if (!url.isValid() || !schemes.contains(url.scheme().toLower())) {
+            continue;
+        }
+        submit_uri(url.toString(), node);
+        found++;
+    }
+    qDebug()<<GREEN<<"SCANNED_URLS::"<<source<<found<<UrlScanner::isa()<<NONE;
+}
+
+void DOMParser::scan_response(const QVariantMap& response)
+{
+    static const QRegularExpression textual("javascript|ecmascript|json|css", QRegularExpression::CaseInsensitiveOption);
+
+    QString type = response.value("contentType").toString().toLower();
+    QByteArray body = response.value("body").toString().toUtf8();
+    if (!m_urlScan || body.isEmpty() || !textual.match(type).hasMatch()) {
+        return;
+    }
+    QUrl url(response.value("url").toString());
+    // url() of a stylesheet is relative to it, paths in scripts to the document
+    bool css = type.contains("css");
+    QUrl base = css ? url : m_webpage->mainFrame()->url();
+    if (base.isEmpty()) {
+        base = url;
+    }
+    scan_text(body, base, css ? "css" : type.contains("json") ? "json" : "script");
+}
+
+// Records found in a child frame carry the frame they come from
+void DOMParser::tag_frame(QVariantMap& result)
+{
+    if (m_frameDepth == 0) {
+        return;
+    }
+    QWebSecurityOrigin origin = m_frame->securityOrigin();
+    QString frame_origin = origin.scheme() + "://" + origin.host();
+    if (origin.port() > 0) {
+        frame_origin += ":" + QString::number(origin.port());
+    }
+    result["frame"] = m_frame->url().toString();
+    result["frame_origin"] = frame_origin;
+    result["frame_depth"] = m_frameDepth;
+}
+
+// Markup of the node as selected by `--dom-xml`, only serialized for records
+// that passed the dedup in submit_uri. Without JavaScript the element falls
+// back to QWebElement::toOuterXml().
+QString DOMParser::node_xml(const QVariantMap& node)
+{
+    static const QString script = Utils::readResourceFileUtf8(":/domxml.js");
+
+    QString args = QString("'%1', %2").arg(m_xmlMode).arg(m_xmlLimit);
+    QVariant markup;
+    if (node.contains("element")) {
+        QWebElement element = node.value("element").value<QWebElement>();
+        markup = element.evaluateJavaScript(QString("(%1)(this, %2);").arg(script, args));
+        if (markup.type() != QVariant::String) {
+            QString xml = element.toOuterXml();
+            return m_xmlMode == "truncate" ? xml.left(m_xmlLimit) : xml;
+        }
+    } else if (node.contains("index")) {
+        markup = m_frame->evaluateJavaScript(QString("(%1)(window.__bradypodNodes[%2], %3);")
+                                             .arg(script).arg(node.value("index").toInt()).arg(args));
+    }
+    return markup.toString();
+}
+
+// i-th resolved URL property of the node, see domextract.js
+static inline QString node_url(const QVariantMap& node, int i = 0)
+{
+    QVariantList urls = node.value("urls").toList();
+    return i < urls.size() ? urls.at(i).toString() : QString();
+}
+
 /* 标签: 基础
  * html title body h1 ... h6 p br hr
  */
-void DOMParser::handle_tag_bases(QWebElement& element)
+void DOMParser::handle_tag_bases(const QVariantMap& node)
 {
-    (void)element;
+    (void)node;
     // ignore
 }
 
@@ -191,9 +588,9 @@ void DOMParser::handle_tag_bases(QWebElement& element)
  * acronym abbr address b bdi bdo big blockquote center cite code del dfn em font i ins kbd mark
  * meter pre progress q rp rt ruby s samp small strike strong sup sub time tt u var wbr
  */
-void DOMParser::handle_tag_formats(QWebElement& element)
+void DOMParser::handle_tag_formats(const QVariantMap& node)
 {
-    (void)element;
+    (void)node;
     // ignore
 }
 
@@ -211,63 +608,68 @@ static QVariantMap getFormInputAttr(const QWebElement& element, const QString& n
     return res;
 }
 
-static void traverseFormDom(const QWebElement& parent, const QWebElement& element ,
-                            QVariantMap& result, QString name=QString())
+// DOMWalker visitor collecting the fields of one form, a control's name is
+// inherited by the elements below it (option -> select)
+class FormVisitor : public DOMVisitor
 {
-    static const QStringList form_parse_tags =
-            QStringList()<<"input"<<"textarea"<<"button"<<"select"<<"optgroup"<<"option"<<"output"<<"datalist"<<"keygen";
-    static const QStringList form_submit_tags = QStringList()<<"input"<<"textarea"<<"button"<<"option";
-    if (element.isNull()) {
-        return;
-    }
-    printSimpleElement(element);
-    if (parent != element) {
-        if (element.tagName().compare("FORM",Qt::CaseInsensitive) == 0) {
-            return;
+public:
+    FormVisitor(const QWebElement& form, QVariantMap& result) : m_form(form), m_result(result) {}
+
+    bool enter(const QWebElement& element, int depth)
+    {
+        static const QStringList form_parse_tags =
+                QStringList()<<"input"<<"textarea"<<"button"<<"select"<<"optgroup"<<"option"<<"output"<<"datalist"<<"keygen";
+        static const QStringList form_submit_tags = QStringList()<<"input"<<"textarea"<<"button"<<"option";
+        (void)depth;
+
+        printSimpleElement(element);
+        QString tagName = element.tagName().toLower();
+        if (element != m_form && tagName == "form") {
+            return false;
         }
-    }
-    // process current element
-    QString tagName = element.tagName().toLower();
-    if (form_parse_tags.contains(tagName,Qt::CaseInsensitive) && element.hasAttribute("name")) {
-        name = element.attribute("name");
-        if (tagName == "datalist") {
-            name = element.attribute("id");
+        // process current element
+        QString name = m_names.isEmpty() ? QString() : m_names.last();
+        if (form_parse_tags.contains(tagName) && element.hasAttribute("name")) {
+            name = element.attribute("name");
+            if (tagName == "datalist") {
+                name = element.attribute("id");
+            }
         }
-    }
-    if (form_submit_tags.contains(tagName,Qt::CaseInsensitive)) {
-        // submit
-        if (!result.contains(name)) {
-            result[name] = QVariantList();
+        if (form_submit_tags.contains(tagName)) {
+            // submit
+            QVariantList values = m_result.value(name).toList();
+            values.append(getFormInputAttr(element,name));
+            m_result[name] = values;
         }
-        QVariantList values = result[name].toList();
-        values.append(getFormInputAttr(element,name));
-        result[name] = values;
+        m_names.append(name);
+        return true;
     }
 
-    // child
-    QWebElement child = element.firstChild();
-    traverseFormDom(element,child,result,name);
-
-    // sibling
-    QWebElement sibling = child.nextSibling();
-    while(!sibling.isNull()) {
-        traverseFormDom(element,sibling,result,name);
-        sibling = sibling.nextSibling();
+    void leave(const QWebElement& element, int depth)
+    {
+        (void)element;
+        (void)depth;
+        m_names.removeLast();
     }
 
-}
+private:
+    QWebElement m_form;
+    QVariantMap& m_result;
+    QStringList m_names;
+};
 
 static QVariantMap staticParserForm(QWebElement& element)
 {
     QVariantMap result;
-    traverseFormDom(element,element,result);
+    FormVisitor visitor(element, result);
+    DOMWalker().walk(element, &visitor);
     return result;
 }
 
-static QVariantMap dynamicParserForm(QWebElement& element)
+static QVariantMap dynamicParserForm(const QVariantMap& node)
 {
     // TODO:
-    (void)element;
+    (void)node;
     return QVariantMap();
 }
 
@@ -275,39 +677,76 @@ static QVariantMap dynamicParserForm(QWebElement& element)
 /* 标签: 表单
  * form input textarea button select optgroup option label fieldset legend isindex datalist keygen output
  */
-void DOMParser::handle_tag_forms(QWebElement& element)
+void DOMParser::handle_tag_forms(const QVariantMap& node)
 {
     // TODO:
-    printSimpleElement(element);
-    QString result = element.evaluateJavaScript("this.action").toString().trimmed();
+    printSimpleNode(node);
+    QString result = node_url(node);
     qDebug()<<"Form: action: "<<result;
 
     // extra url
     if (!result.isEmpty() && QUrl(result).isValid()) {
-        submit_uri(result,element,"GET");
+        submit_uri(result,node,"GET");
     }
     // static parser
-    QVariantMap static_body = staticParserForm(element);
+    QVariantMap static_body = node.value("fields").toMap();
     if (!static_body.isEmpty()) {
-        submit_uri(result,element,"",static_body);
+        submit_uri(result,node,"",static_body);
     }
     // dynamic parser
-    QVariantMap dynamic_body = dynamicParserForm(element);
+    QVariantMap dynamic_body = dynamicParserForm(node);
     if (!dynamic_body.isEmpty()) {
-        submit_uri(result,element,"",dynamic_body);
+        submit_uri(result,node,"",dynamic_body);
+    }
+    // sent by replay_forms() once the frame is parsed
+    if (m_formReplayVariants > 0 && !static_body.isEmpty()) {
+        m_forms.append(node);
     }
 }
 
+void DOMParser::replay_forms()
+{
+    if (m_frame.isNull()) {
+        // their actions resolve against a frame that is gone
+        m_forms.clear();
+    }
+    if (m_forms.isEmpty()) {
+        return;
+    }
+    int sent = 0;
+    foreach (const QVariantMap& node, m_forms) {
+        QString action = node_url(node);
+        if (action.isEmpty() || !QUrl(action).isValid()) {
+            continue;
+        }
+        QString method = node.value("method").toString();
+        foreach (QUrlQuery query, FormReplay::variants(node.value("fields").toMap(), m_formReplayVariants)) {
+            QString key = "replay-" + method.toLower() + "-" + action + "?" + query.toString(QUrl::FullyEncoded);
+            if (m_rescheduling.insert(key.toUtf8())) {
+                m_replay->submit(action, method, query);
+                sent++;
+            }
+        }
+    }
+    m_forms.clear();
+    qDebug()<<GREEN<<"FORM_REPLAY::"<<sent<<NONE;
+}
+
+void DOMParser::finish_replay()
+{
+    m_replay->drain(m_formReplayTimeout);
+}
+
 
 /* 标签: 框架
  * frame frameset noframes iframe
  */
-void DOMParser::handle_tag_frames(QWebElement& element)
+void DOMParser::handle_tag_frames(const QVariantMap& node)
 {
-    printSimpleElement(element);
-    QString src = element.evaluateJavaScript("this.src").toString();
+    printSimpleNode(node);
+    QString src = node_url(node);
     if (!src.isEmpty() && QUrl(src).isValid()) {
-        submit_uri(src,element);
+        submit_uri(src,node);
     }
 }
 
@@ -325,14 +764,14 @@ void DOMParser::handle_tag_frames(QWebElement& element)
 /* 标签: 图像
  * img map area canvas figcaption figure
  */
-void DOMParser::handle_tag_images(QWebElement& element)
+void DOMParser::handle_tag_images(const QVariantMap& node)
 {
-    printSimpleElement(element);
+    printSimpleNode(node);
 //    WebCore::Element* wkt_element = QtWebElementRuntime::get(element);
-    QString js = element.tagName().toLower() == "area" ? "this.href" : "this.src";
-    QString result = element.evaluateJavaScript(js).toString().trimmed();
+    // area: this.href, other: this.src
+    QString result = node_url(node);
     if (!result.isEmpty() && QUrl(result).isValid()) {
-        submit_uri(result,element);
+        submit_uri(result,node);
     }
 }
 
@@ -340,12 +779,12 @@ void DOMParser::handle_tag_images(QWebElement& element)
 /* 标签: 音频/视频
  * audio source track video
  */
-void DOMParser::handle_tag_media(QWebElement& element)
+void DOMParser::handle_tag_media(const QVariantMap& node)
 {
-    printSimpleElement(element);
-    QString src = element.evaluateJavaScript("this.src").toString().trimmed();
+    printSimpleNode(node);
+    QString src = node_url(node);
     if (!src.isEmpty() && QUrl(src).isValid()) {
-        submit_uri(src,element);
+        submit_uri(src,node);
     }
 }
 
@@ -353,27 +792,24 @@ void DOMParser::handle_tag_media(QWebElement& element)
 /* 标签: 链接
  * a link nav
  */
-void DOMParser::handle_tag_hyperlinks(QWebElement& element)
+void DOMParser::handle_tag_hyperlinks(const QVariantMap& node)
 {
-    printSimpleElement(element);
-    QString href = element.evaluateJavaScript("this.href").toString().trimmed();
+    printSimpleNode(node);
+    QString href = node_url(node);
     if (href.isEmpty())
         return;
-    submit_uri(href,element);
+    submit_uri(href,node);
     if (href.startsWith("javascript",Qt::CaseInsensitive)) {
-        emulate_click(element);
-        wait(50,50);
+        queue_click(node);
     } else {
         QUrl url(href);
         if (url.hasFragment() && !url.fragment().isEmpty()) {
             qDebug()<<"hasFragment::"<<url.fragment();
-            emulate_click(element);
-            wait(50,50);
+            queue_click(node);
 //        } else if (!element.attribute("onclick").trimmed().isEmpty()) {
-        } else if (element.evaluateJavaScript("this.onclick == null ? \"false\" : \"true\"").toBool()) {
-            qDebug()<<"onclick::"<<element.attribute("onclick");
-            emulate_click(element);
-            wait(50,50);
+        } else if (node.value("onclick").toBool()) {
+            qDebug()<<"onclick::"<<href;
+            queue_click(node);
         }
     }
 }
@@ -382,9 +818,9 @@ void DOMParser::handle_tag_hyperlinks(QWebElement& element)
 /* 标签: 列表
  * ul ol li dir dl dt dd menu menuitem command
  */
-void DOMParser::handle_tag_list(QWebElement& element)
+void DOMParser::handle_tag_list(const QVariantMap& node)
 {
-    (void)element;
+    (void)node;
     // ignore
 }
 
@@ -392,9 +828,9 @@ void DOMParser::handle_tag_list(QWebElement& element)
 /* 标签: 表格
  * table caption th tr td thead tbody tfoot col colgroup
  */
-void DOMParser::handle_tag_table(QWebElement& element)
+void DOMParser::handle_tag_table(const QVariantMap& node)
 {
-    (void)element;
+    (void)node;
     // ignore
 }
 
@@ -402,9 +838,9 @@ void DOMParser::handle_tag_table(QWebElement& element)
 /* 标签: 样式/节
  * style div span header footer section article aside details dialog summary details
  */
-void DOMParser::handle_tag_sections(QWebElement& element)
+void DOMParser::handle_tag_sections(const QVariantMap& node)
 {
-    (void)element;
+    (void)node;
     // ignore
 }
 
@@ -412,19 +848,19 @@ void DOMParser::handle_tag_sections(QWebElement& element)
 /* 标签: 元信息
  * head meta base basefont
  */
-void DOMParser::handle_tag_meta(QWebElement& element)
+void DOMParser::handle_tag_meta(const QVariantMap& node)
 {
-    printSimpleElement(element);
-    QString tagName = element.tagName().toLower();
+    printSimpleNode(node);
+    QString tagName = node.value("tag").toString().toLower();
     if (tagName == "base") {
-        QString result = element.evaluateJavaScript("this.href").toString().trimmed();
+        QString result = node_url(node);
         if (result.isEmpty())
             return;
-        submit_uri(result,element);
+        submit_uri(result,node);
     } else if (tagName == "meta") {
-        QString httpEquiv = element.attribute("http-equiv").toLower().trimmed();
-        if (httpEquiv == "refresh") {
-            QStringList sec_url = element.attribute("content").trimmed().split("=");
+        // domextract.js only reports http-equiv="refresh"
+        if (node.contains("content")) {
+            QStringList sec_url = node.value("content").toString().split("=");
             if (sec_url.length() < 1)
                 return;
             QString url = sec_url[sec_url.length() - 1];    // last one
@@ -432,10 +868,10 @@ void DOMParser::handle_tag_meta(QWebElement& element)
                                                   QRegularExpression::UseUnicodePropertiesOption).
                     match(url).hasMatch();
             if (!proto_exist) {
-                url = element.webFrame()->baseUrl().resolved(QUrl(url)).toString();
+                url = m_frame->baseUrl().resolved(QUrl(url)).toString();
             }
             if (!url.isEmpty() && QUrl(url).isValid())
-                submit_uri(url,element);
+                submit_uri(url,node);
         }
     } else {
         return;
@@ -446,33 +882,16 @@ void DOMParser::handle_tag_meta(QWebElement& element)
 /* 标签: 编程
  * script noscript applet embed object param
  */
-void DOMParser::handle_tag_script(QWebElement& element)
+void DOMParser::handle_tag_script(const QVariantMap& node)
 {
-    printSimpleElement(element);
-    QString tagName = element.tagName().toLower();
-    static const QString src_tags = "script,noscript,embed";
-    if (src_tags.contains(tagName)) {
-        QString src = element.evaluateJavaScript("this.src").toString().trimmed();
+    printSimpleNode(node);
+    // script, noscript, embed: this.src
+    // applet: this.code, this.codebase, this.data, this.usemap
+    // object: this.archive, this.codebase, this.data, this.usemap
+    foreach (QVariant url, node.value("urls").toList()) {
+        QString src = url.toString();
         if (!src.isEmpty() && QUrl(src).isValid())
-            submit_uri(src,element);
-    } else if (tagName == "applet") {
-        QStringList js_codes;
-        js_codes << "this.code" << "this.codebase" << "this.data" << "this.usemap";
-        foreach (QString code, js_codes) {
-            QString src = element.evaluateJavaScript(code).toString().trimmed();
-            if (!src.isEmpty() && QUrl(src).isValid())
-                submit_uri(src,element);
-        }
-    } else if (tagName == "object") {
-        QStringList js_codes;
-        js_codes << "this.archive" << "this.codebase" << "this.data" << "this.usemap";
-        foreach (QString code, js_codes) {
-            QString src = element.evaluateJavaScript(code).toString().trimmed();
-            if (!src.isEmpty() && QUrl(src).isValid())
-                submit_uri(src,element);
-        }
-    } else {
-        return;
+            submit_uri(src,node);
     }
 }
 
@@ -480,15 +899,48 @@ void DOMParser::handle_tag_script(QWebElement& element)
 /* 标签: 其他
  * ...
  */
-void DOMParser::handle_tag_other(QWebElement& element)
+void DOMParser::handle_tag_other(const QVariantMap& node)
 {
-    (void)element;
-    printSimpleElement(element);
+    (void)node;
+    printSimpleNode(node);
 }
 
-void DOMParser::wait(int msec, int per_cost)
+// Returns once the page has been quiet (no DOM mutation, no XHR/fetch in
+// flight, see domsettle.js) for m_settleQuiet ms, or after m_settleTimeout ms.
+// The event loop sleeps between the checks instead of spinning.
+void DOMParser::settle()
 {
-    QTime dieTime = QTime::currentTime().addMSecs(msec);
-    while (QTime::currentTime() < dieTime)
-        QCoreApplication::processEvents(QEventLoop::AllEvents, per_cost);
+    static const int poll_interval = 10;
+    static const QString quiet_js = "(function (s) {"
+            "  return !s ? -2 : s.pending > 0 ? -1 : Date.now() - s.last;"
+            "})(window.__bradypodSettle);";
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    QEventLoop loop;
+    QTimer poll;
+    poll.setInterval(poll_interval);
+    connect(&poll, SIGNAL(timeout()), &loop, SLOT(quit()));
+    poll.start();
+
+    forever {
+        loop.exec();
+        if (m_frame.isNull()) {
+            break;
+        }
+        qint64 waited = elapsed.elapsed();
+        qint64 quiet = qint64(m_frame->evaluateJavaScript(quiet_js).toDouble());
+        if (quiet == -2) {
+            // monitor not installed (scripts disabled, or the click navigated)
+            quiet = waited;
+        }
+        // only quiet time since the click counts
+        if (quiet >= 0 && qMin(quiet, waited) >= m_settleQuiet) {
+            break;
+        }
+        if (waited >= m_settleTimeout) {
+            qDebug()<<RED<<"settle timeout, pending:"<<(quiet == -1)<<NONE;
+            break;
+        }
+    }
 }
@@ -2,9 +2,15 @@
 #define DOMPARSER_H
 
 #include <QObject>
+#include <QPointer>
 #include <QWebElement>
 #include "webpage.h"
 #include "consts.h"
+#include "seenset.h"
+#include "domwalker.h"
+#include "domtags.h"
+
+class FormReplay;
 
 class DOMParser : public QObject
 {
@@ -12,94 +18,189 @@ class DOMParser : public QObject
 public:
     explicit DOMParser(QObject *parent, WebPage* webpage);
 
+    /**
+     * Runs domextract.js in the main frame, one call that returns every
+     * element carrying a URI, and hands the entries to the tag handlers.
+     * When the script can not run the elements are walked from C++.
+     *
+     * After each round of clicks only the subtrees added or changed since
+     * the previous extraction are extracted again, until a round queues no
+     * new click or `--dom-reparse-rounds` rounds ran.
+     *
+     * Child frames already loaded are parsed the same way afterwards, down
+     * to `--frame-depth`; their records carry frame, frame_origin and
+     * frame_depth.
+     */
     void parse_traversal_dom();
 
+    void reset();
+
+    /**
+     * An element as the node map of domextract.js: tag, urls, type, method,
+     * onclick, fields, content, plus "element" for the QWebElement.
+     */
+    QVariantMap element_node(QWebElement& element);
+
     void parse_element(QWebElement& element);
 
-    void emulate_click(QWebElement &element,QString jscode=JS_ELEMENT_CLICK);
+    void parse_node(const QVariantMap& node);
+
+    void emulate_click(const QVariantMap& node,QString jscode=JS_ELEMENT_CLICK);
+
+    /**
+     * Clicks are queued by the tag handlers and run by run_clicks() once the
+     * document has been parsed, `--click-batch` at a time with one settle()
+     * per batch.
+     */
+    void queue_click(const QVariantMap& node);
+
+    /**
+     * Runs the queued clicks. Requests (tagged "initiator" by the network
+     * access manager), navigations and DOM mutations are attributed to the
+     * click that caused them while it runs, and to its batch afterwards;
+     * emits one "dom_click" record per click that had any effect.
+     */
+    void run_clicks();
+
+    void submit_uri(const QString& uri, const QVariantMap& node, const QString& method="", const QVariantMap& body=QVariantMap());
+
+    /**
+     * URLs and paths UrlScanner finds in `text`, relative ones resolved
+     * against `base`, submitted with tag_name "#<source>" (html, script,
+     * json, css). Off with '--url-scan false'.
+     */
+    void scan_text(const QByteArray& text, const QUrl& base, const QString& source);
+
+    /**
+     * scan_text() over the body of a script, JSON or CSS response
+     * (a resourceReceived record).
+     */
+    void scan_response(const QVariantMap& response);
+
+    /**
+     * Submits the variants of the forms found in the frame with FormReplay,
+     * '--form-replay' variants per form, without waiting for the responses
+     * (see finish_replay()).
+     */
+    void replay_forms();
 
-    void submit_uri(const QString& uri, const QWebElement& element, const QString& method="", const QVariantMap& body=QVariantMap());
+    /**
+     * Emits replayFinished() once every form replay submission is answered,
+     * or aborted after '--form-replay-timeout' ms.
+     */
+    void finish_replay();
 
     /* 标签: 基础
      * html title body h1 ... h6 p br hr
      */
-    void handle_tag_bases(QWebElement& element);
+    void handle_tag_bases(const QVariantMap& node);
 
     /* 标签: 格式
      * acronym abbr address b bdi bdo big blockquote center cite code del dfn em font i ins kbd mark
      * meter pre progress q rp rt ruby s samp small strike strong sup sub time tt u var wbr
      */
-    void handle_tag_formats(QWebElement& element);
+    void handle_tag_formats(const QVariantMap& node);
 
     /* 标签: 表单
      * form input textarea button select optgroup option label fieldset legend isindex datalist keygen output
      */
-    void handle_tag_forms(QWebElement& element);
+    void handle_tag_forms(const QVariantMap& node);
 
     /* 标签: 框架
      * frame frameset noframes iframe
      */
-    void handle_tag_frames(QWebElement& element);
+    void handle_tag_frames(const QVariantMap& node);
 
     /* 标签: 图像
      * img map area canvas figcaption figure
      */
-    void handle_tag_images(QWebElement& element);
+    void handle_tag_images(const QVariantMap& node);
 
     /* 标签: 音频/视频
      * audio source track video
      */
-    void handle_tag_media(QWebElement& element);
+    void handle_tag_media(const QVariantMap& node);
 
     /* 标签: 链接
      * a link nav
      */
-    void handle_tag_hyperlinks(QWebElement& element);
+    void handle_tag_hyperlinks(const QVariantMap& node);
 
     /* 标签: 列表
      * ul ol li dir dl dt dd menu menuitem command
      */
-    void handle_tag_list(QWebElement& element);
+    void handle_tag_list(const QVariantMap& node);
 
     /* 标签: 表格
      * table caption th tr td thead tbody tfoot col colgroup
      */
-    void handle_tag_table(QWebElement& element);
+    void handle_tag_table(const QVariantMap& node);
 
     /* 标签: 样式/节
      * style div span header footer section article aside details dialog summary details
      */
-    void handle_tag_sections(QWebElement& element);
+    void handle_tag_sections(const QVariantMap& node);
 
     /* 标签: 元信息
      * head meta base basefont
      */
-    void handle_tag_meta(QWebElement& element);
+    void handle_tag_meta(const QVariantMap& node);
 
     /* 标签: 编程
      * script noscript applet embed object param
      */
-    void handle_tag_script(QWebElement& element);
+    void handle_tag_script(const QVariantMap& node);
 
     /* 标签: 其他
      * ...
      */
-    void handle_tag_other(QWebElement& element);
+    void handle_tag_other(const QVariantMap& node);
 
 signals:
     void parsedLinks(const QVariant& resource);
+    void replayFinished();
 
 public slots:
 
+private slots:
+    void on_resourceRequested(const QVariant& data, QObject* request);
+    void on_navigationRequested(const QString& url, const QString& navigationType, bool navigationLocked, bool isMainFrame);
+
 private:
     WebPage* m_webpage;
     DOMParser* domparser;
     QWebElement m_webEelement;
-    QSet<QByteArray> m_rescheduling;
+    SeenSet m_rescheduling;
+    DOMWalker::Options m_walkOptions;
+    DOMTags m_tags;
+    int m_settleQuiet;
+    int m_settleTimeout;
+    int m_clickBatch;
+    int m_reparseRounds;
+    QString m_xmlMode;
+    int m_xmlLimit;
+    // a click in the parent may delete the frame being parsed
+    QPointer<QWebFrame> m_frame;
+    int m_frameDepth;
+    int m_maxFrameDepth;
+    bool m_urlScan;
+    FormReplay* m_replay;
+    QList<QVariantMap> m_forms;
+    int m_formReplayVariants;
+    int m_formReplayTimeout;
+    QList<QVariantMap> m_clicks;
+    QString m_clickTag;
+    QMap<QString, QVariantList> m_clickRequests;
 
     void _traversal_dom(QWebElement &curElement);
-
-    void wait(int msec, int per_cost = 80);
+    bool _extract_nodes(QVariantList& nodes, bool dirty = false);
+
+    void settle();
+    void parse_frame();
+    void parse_child_frames(QWebFrame* parent, int depth);
+    void tag_frame(QVariantMap& result);
+    QString node_xml(const QVariantMap& node);
+    void set_click_tag(const QString& tag);
 };
 
 #endif // DOMPARSER_H
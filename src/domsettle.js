@@ -0,0 +1,97 @@
+// Settle monitor of DOMParser, evaluated in the main frame before emulated
+// clicks. Installed once per document.
+//
+// window.__bradypodSettle:
+//   pending  XMLHttpRequest / fetch calls in flight
+//   last     Date.now() of the last DOM mutation or request start / end
+//   click    id of the emulated click running, set by DOMParser
+//   mutations  click id -> number of DOM mutation records seen under it
+//   dirty    elements added (subtree) or whose attributes changed (shallow)
+//            since the last extraction, taken by domextract.js
+//   overflow more than DIRTY_MAX entries, the next extraction walks the document
+(function () {
+    if (window.__bradypodSettle) {
+        return;
+    }
+    var DIRTY_MAX = 10000;
+    var state = window.__bradypodSettle = { pending: 0, last: Date.now(), click: null, mutations: {},
+                                            dirty: [], overflow: false };
+
+    function touch() {
+        state.last = Date.now();
+    }
+
+    function dirty(el, shallow) {
+        if (state.dirty.length < DIRTY_MAX) {
+            state.dirty.push({ el: el, shallow: shallow });
+        } else {
+            state.overflow = true;
+        }
+    }
+
+    var Observer = window.MutationObserver || window.WebKitMutationObserver;
+    if (Observer && document.documentElement) {
+        new Observer(function (records) {
+            if (state.click !== null) {
+                state.mutations[state.click] = (state.mutations[state.click] || 0) + records.length;
+            }
+            for (var r = 0; r < records.length; ++r) {
+                var record = records[r];
+                if (record.type === 'attributes') {
+                    dirty(record.target, true);
+                } else if (record.type === 'childList') {
+                    for (var n = 0; n < record.addedNodes.length; ++n) {
+                        if (record.addedNodes[n].nodeType === 1) {
+                            dirty(record.addedNodes[n], false);
+                        }
+                    }
+                }
+            }
+            touch();
+        }).observe(document.documentElement,
+                                    { childList: true, subtree: true, attributes: true, characterData: true });
+    }
+
+    if (window.XMLHttpRequest) {
+        var send = XMLHttpRequest.prototype.send;
+        XMLHttpRequest.prototype.send = function () {
+            var done = false;
+            function finish() {
+                if (!done) {
+                    done = true;
+                    state.pending--;
+                    touch();
+                }
+            }
+            state.pending++;
+            touch();
+            this.addEventListener('load', finish);
+            this.addEventListener('error', finish);
+            this.addEventListener('abort', finish);
+            this.addEventListener('timeout', finish);
+            try {
+                return send.apply(this, arguments);
+            } catch (e) {
+                finish();
+                throw e;
+            }
+        };
+    }
+
+    if (window.fetch) {
+        var fetch = window.fetch;
+        window.fetch = function () {
+            state.pending++;
+            touch();
+            return fetch.apply(this, arguments).then(function (response) {
+                state.pending--;
+                touch();
+                return response;
+            }, function (error) {
+                state.pending--;
+                touch();
+                throw error;
+            });
+        };
+    }
+})();
@@ -0,0 +1,118 @@
+#include "domtags.h"
+
+static const char* const category_names[DOMTags::CategoryCount] = {
+    "other", "base", "format", "form", "form_element", "frame", "image", "media",
+    "hyperlink", "list", "table", "section", "meta", "script", "ignore"
+};
+
+// lower case ASCII `tag` equals `name`
+static inline bool tagEquals(const QString& tag, const char* name)
+{
+    const QChar* c = tag.constData();
+    const int length = tag.length();
+    for (int i = 0; i < length; ++i, ++name) {
+        ushort u = c[i].unicode();
+        if (u >= 'A' && u <= 'Z') {
+            u += 'a' - 'A';
+        }
+        if (!*name || u != uchar(*name)) {
+            return false;
+        }
+    }
+    return !*name;
+}
+
+DOMTags::Category DOMTags::builtin(const QString& tag)
+{
+    quint32 h = 2166136261u;
+    const QChar* c = tag.constData();
+    const int length = tag.length();
+    for (int i = 0; i < length; ++i) {
+        ushort u = c[i].unicode();
+        if (u > 0x7f) {
+            return Other;
+        }
+        if (u >= 'A' && u <= 'Z') {
+            u += 'a' - 'A';
+        }
+        h = (h ^ u) * 16777619u;
+    }
+
+    switch (h) {
+#define BRADYPOD_DOM_TAG_CASE(name, category) \
+    case hash(#name): return tagEquals(tag, #name) ? category : Other;
+    BRADYPOD_DOM_TAGS(BRADYPOD_DOM_TAG_CASE)
+#undef BRADYPOD_DOM_TAG_CASE
+    default:
+        return Other;
+    }
+}
+
+QString DOMTags::categoryName(Category category)
+{
+    return QString::fromLatin1(category_names[category]);
+}
+
+DOMTags::Category DOMTags::categoryFromName(const QString& name, bool* ok)
+{
+    for (int i = 0; i < CategoryCount; ++i) {
+        if (name.compare(QLatin1String(category_names[i]), Qt::CaseInsensitive) == 0) {
+            if (ok) {
+                *ok = true;
+            }
+            return Category(i);
+        }
+    }
+    if (ok) {
+        *ok = false;
+    }
+    return Other;
+}
+
+DOMTags::DOMTags()
+{
+    for (int i = 0; i < CategoryCount; ++i) {
+        m_disabled[i] = false;
+    }
+}
+
+bool DOMTags::setRules(const QString& rules, QString* error)
+{
+    foreach (QString rule, rules.split(",", QString::SkipEmptyParts)) {
+        rule = rule.trimmed();
+        bool ok = false;
+        if (rule.startsWith('-')) {
+            Category category = categoryFromName(rule.mid(1), &ok);
+            if (ok) {
+                m_disabled[category] = true;
+            }
+        } else {
+            int index = rule.indexOf(':');
+            if (index > 0) {
+                Category category = categoryFromName(rule.mid(index + 1).trimmed(), &ok);
+                if (ok) {
+                    m_overrides[rule.left(index).trimmed().toLower()] = category;
+                }
+            }
+        }
+        if (!ok) {
+            if (error) {
+                *error = rule;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+QHash<QString, DOMTags::Category> DOMTags::overrides() const
+{
+    return m_overrides;
+}
+
+DOMTags::Category DOMTags::classify(const QString& tag) const
+{
+    Category category = m_overrides.isEmpty() ? builtin(tag)
+                                              : m_overrides.value(tag.toLower(), builtin(tag));
+    return m_disabled[category] ? Ignore : category;
+}
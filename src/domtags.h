@@ -0,0 +1,101 @@
+#ifndef DOMTAGS_H
+#define DOMTAGS_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+/**
+ * Tag catalogue of DOMParser: tag name -> handler category.
+ *
+ * The built-in catalogue is the BRADYPOD_DOM_TAGS table below. Lookup hashes
+ * the tag name (FNV-1a, ASCII case folded on the fly, no allocation) and
+ * switches on the hashes of the table computed at compile time; two tags
+ * with the same hash would be duplicate case labels, so the hash is known
+ * to be perfect for the catalogue. A final compare rejects unknown tags.
+ *
+ * Rules ('--dom-tag-rules') adjust the catalogue at runtime:
+ *   tag:category   handle `tag` as `category` (e.g. x-link:hyperlink)
+ *   -category      disable a category (its tags are ignored)
+ * separated by commas.
+ */
+class DOMTags
+{
+public:
+    enum Category {
+        Other = 0,
+        Base,
+        Format,
+        Form,
+        FormElement,
+        Frame,
+        Image,
+        Media,
+        Hyperlink,
+        List,
+        Table,
+        Section,
+        Meta,
+        Script,
+        Ignore,
+        CategoryCount
+    };
+
+#define BRADYPOD_DOM_TAGS(X) \
+    X(html, Base) X(title, Base) X(body, Base) X(h1, Base) X(h2, Base) X(h3, Base) X(h4, Base) \
+    X(h5, Base) X(h6, Base) X(p, Base) X(br, Base) X(hr, Base) \
+    X(acronym, Format) X(abbr, Format) X(address, Format) X(b, Format) X(bdi, Format) X(bdo, Format) \
+    X(big, Format) X(blockquote, Format) X(center, Format) X(cite, Format) X(code, Format) X(del, Format) \
+    X(dfn, Format) X(em, Format) X(font, Format) X(i, Format) X(ins, Format) X(kbd, Format) X(mark, Format) \
+    X(meter, Format) X(pre, Format) X(progress, Format) X(q, Format) X(rp, Format) X(rt, Format) \
+    X(ruby, Format) X(s, Format) X(samp, Format) X(small, Format) X(strike, Format) X(strong, Format) \
+    X(sup, Format) X(sub, Format) X(time, Format) X(tt, Format) X(u, Format) X(var, Format) X(wbr, Format) \
+    X(form, Form) \
+    X(input, FormElement) X(textarea, FormElement) X(button, FormElement) X(select, FormElement) \
+    X(optgroup, FormElement) X(option, FormElement) X(label, FormElement) X(fieldset, FormElement) \
+    X(legend, FormElement) X(isindex, FormElement) X(datalist, FormElement) X(keygen, FormElement) \
+    X(output, FormElement) \
+    X(frame, Frame) X(frameset, Frame) X(noframes, Frame) X(iframe, Frame) \
+    X(img, Image) X(map, Image) X(area, Image) X(canvas, Image) X(figcaption, Image) X(figure, Image) \
+    X(audio, Media) X(source, Media) X(track, Media) X(video, Media) \
+    X(a, Hyperlink) X(link, Hyperlink) X(nav, Hyperlink) \
+    X(ul, List) X(ol, List) X(li, List) X(dir, List) X(dl, List) X(dt, List) X(dd, List) X(menu, List) \
+    X(menuitem, List) X(command, List) \
+    X(table, Table) X(caption, Table) X(th, Table) X(tr, Table) X(td, Table) X(thead, Table) \
+    X(tbody, Table) X(tfoot, Table) X(col, Table) X(colgroup, Table) \
+    X(style, Section) X(div, Section) X(span, Section) X(header, Section) X(footer, Section) \
+    X(section, Section) X(article, Section) X(aside, Section) X(details, Section) X(dialog, Section) \
+    X(summary, Section) \
+    X(head, Meta) X(meta, Meta) X(base, Meta) X(basefont, Meta) \
+    X(script, Script) X(noscript, Script) X(applet, Script) X(embed, Script) X(object, Script) X(param, Script)
+
+    static constexpr quint32 hash(const char* name, quint32 h = 2166136261u)
+    {
+        return *name ? hash(name + 1, (h ^ quint32(uchar(*name))) * 16777619u) : h;
+    }
+
+    /**
+     * Built-in category of `tag`, any case.
+     */
+    static Category builtin(const QString& tag);
+
+    static QString categoryName(Category category);
+    static Category categoryFromName(const QString& name, bool* ok = 0);
+
+    DOMTags();
+
+    bool setRules(const QString& rules, QString* error = 0);
+
+    /**
+     * Overridden tags, lower case, with their category.
+     */
+    QHash<QString, Category> overrides() const;
+
+    Category classify(const QString& tag) const;
+
+private:
+    QHash<QString, Category> m_overrides;
+    bool m_disabled[CategoryCount];
+};
+
+#endif // DOMTAGS_H
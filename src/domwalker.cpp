@@ -0,0 +1,72 @@
+#include "domwalker.h"
+
+#include <QVector>
+
+DOMWalker::DOMWalker(const Options& options)
+    : m_options(options)
+    , m_truncated(false)
+{
+}
+
+int DOMWalker::walk(const QWebElement& root, DOMVisitor* visitor)
+{
+    struct Frame {
+        QWebElement element;
+        int depth;
+        bool entered;
+    };
+
+    m_truncated = false;
+    int visited = 0;
+    QVector<Frame> stack;
+    if (!root.isNull()) {
+        Frame frame = { root, 0, false };
+        stack.append(frame);
+    }
+
+    while (!stack.isEmpty()) {
+        Frame frame = stack.takeLast();
+        if (frame.entered) {
+            visitor->leave(frame.element, frame.depth);
+            continue;
+        }
+
+        if (!m_options.skipTags.isEmpty() && m_options.skipTags.contains(frame.element.localName().toLower())) {
+            continue;
+        }
+        QWebElement last = frame.element.lastChild();
+        if (m_options.skipTextOnly && last.isNull() && !frame.element.hasAttributes()) {
+            continue;
+        }
+        if (m_options.maxNodes > 0 && visited >= m_options.maxNodes) {
+            m_truncated = true;
+            break;
+        }
+
+        visited++;
+        if (!visitor->enter(frame.element, frame.depth)) {
+            continue;
+        }
+        frame.entered = true;
+        stack.append(frame);
+
+        if (last.isNull()) {
+            continue;
+        }
+        if (m_options.maxDepth > 0 && frame.depth >= m_options.maxDepth) {
+            m_truncated = true;
+            continue;
+        }
+        // pushed last to first, popped in document order
+        for (QWebElement child = last; !child.isNull(); child = child.previousSibling()) {
+            Frame next = { child, frame.depth + 1, false };
+            stack.append(next);
+        }
+    }
+    return visited;
+}
+
+bool DOMWalker::truncated() const
+{
+    return m_truncated;
+}
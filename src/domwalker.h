@@ -0,0 +1,68 @@
+#ifndef DOMWALKER_H
+#define DOMWALKER_H
+
+#include <QStringList>
+#include <QWebElement>
+
+/**
+ * Callbacks of a DOMWalker walk.
+ */
+class DOMVisitor
+{
+public:
+    virtual ~DOMVisitor() {}
+
+    /**
+     * Called before the children of `element`.
+     * @return false to skip the children (and leave())
+     */
+    virtual bool enter(const QWebElement& element, int depth) = 0;
+
+    /**
+     * Called after the children of an element enter() accepted.
+     */
+    virtual void leave(const QWebElement& element, int depth)
+    {
+        (void)element;
+        (void)depth;
+    }
+};
+
+/**
+ * Depth first, document order walk of an element tree on an explicit stack,
+ * so deep DOMs do not grow the C++ stack.
+ *
+ * Pruning:
+ *  - subtrees of `skipTags` (lower case, e.g. svg style) are not entered,
+ *  - with `skipTextOnly` elements without attributes and element children
+ *    (plain text wrappers) are not visited,
+ *  - children deeper than `maxDepth` are not visited,
+ *  - the walk stops after `maxNodes` visited elements.
+ * 0 means no limit. truncated() tells if a limit cut the walk short.
+ */
+class DOMWalker
+{
+public:
+    struct Options {
+        Options() : maxDepth(0), maxNodes(0), skipTextOnly(false) {}
+        QStringList skipTags;
+        int maxDepth;
+        int maxNodes;
+        bool skipTextOnly;
+    };
+
+    explicit DOMWalker(const Options& options = Options());
+
+    /**
+     * @return number of elements passed to enter()
+     */
+    int walk(const QWebElement& root, DOMVisitor* visitor);
+
+    bool truncated() const;
+
+private:
+    Options m_options;
+    bool m_truncated;
+};
+
+#endif // DOMWALKER_H
@@ -0,0 +1,58 @@
+// Markup of an element for the "xml" field of DOMParser records, evaluated
+// as (<this file>)(element, mode, limit) and only for records that are kept:
+//   'full'      outerHTML
+//   'tag'       opening tag with its attributes, children are not serialized
+//   'truncate'  the first `limit` characters of the markup; the subtree is
+//               serialized only as far as needed
+(function (el, mode, limit) {
+    var VOID = { 'area': true, 'base': true, 'br': true, 'col': true, 'embed': true, 'hr': true, 'img': true,
+                 'input': true, 'keygen': true, 'link': true, 'meta': true, 'param': true, 'source': true,
+                 'track': true, 'wbr': true };
+
+    function escape(text, attribute) {
+        text = text.replace(/&/g, '&amp;').replace(/\u00a0/g, '&nbsp;');
+        return attribute ? text.replace(/"/g, '&quot;') : text.replace(/</g, '&lt;').replace(/>/g, '&gt;');
+    }
+
+    function openTag(el) {
+        var markup = '<' + el.tagName.toLowerCase();
+        for (var i = 0; i < el.attributes.length; ++i) {
+            markup += ' ' + el.attributes[i].name + '="' + escape(el.attributes[i].value, true) + '"';
+        }
+        return markup + '>';
+    }
+
+    if (!el) {
+        return '';
+    }
+    if (mode === 'full') {
+        return el.outerHTML;
+    }
+    if (mode === 'tag') {
+        return openTag(el);
+    }
+
+    // same output as outerHTML (comments aside) up to `limit` characters
+    var out = '';
+    var stack = [{ node: el, close: false }];
+    while (stack.length && out.length < limit) {
+        var item = stack.pop();
+        var node = item.node;
+        if (item.close) {
+            out += '</' + node.tagName.toLowerCase() + '>';
+        } else if (node.nodeType === 3) {
+            var parent = node.parentNode ? node.parentNode.nodeName.toLowerCase() : '';
+            out += parent === 'script' || parent === 'style' ? node.data : escape(node.data, false);
+        } else if (node.nodeType === 1) {
+            out += openTag(node);
+            if (!VOID[node.tagName.toLowerCase()]) {
+                stack.push({ node: node, close: true });
+                // reversed, children are serialized in document order
+                for (var child = node.lastChild; child; child = child.previousSibling) {
+                    stack.push({ node: child, close: false });
+                }
+            }
+        }
+    }
+    return out.substring(0, limit);
+})
@@ -0,0 +1,252 @@
+#include "formreplay.h"
+#include "webpage.h"
+
+#include <QDebug>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSet>
+#include <QTimer>
+
+// what a user would type into an empty control, by input type
+static QString sample_value(const QString& type)
+{
+    static QHash<QString, QString> samples;
+    if (samples.isEmpty()) {
+        samples["email"] = "test@example.com";
+        samples["number"] = "1";
+        samples["range"] = "1";
+        samples["tel"] = "13800000000";
+        samples["url"] = "http://example.com/";
+        samples["date"] = "2020-01-01";
+        samples["datetime-local"] = "2020-01-01T00:00";
+        samples["month"] = "2020-01";
+        samples["week"] = "2020-W01";
+        samples["time"] = "00:00";
+        samples["color"] = "#000000";
+        samples["password"] = "Test1234!";
+    }
+    return samples.value(type, "test");
+}
+
+// values of one field name: submitted by default, and the alternatives tried
+struct FormField {
+    QString name;
+    QStringList values;
+    QList<QStringList> alternatives;
+};
+
+static QString encode(const QList<FormField>& fields, int replaced = -1, const QStringList& values = QStringList())
+{
+    QStringList pairs;
+    for (int i = 0; i < fields.size(); ++i) {
+        QByteArray name = QUrl::toPercentEncoding(fields.at(i).name);
+        foreach (QString value, i == replaced ? values : fields.at(i).values) {
+            pairs << QString::fromLatin1(name + "=" + QUrl::toPercentEncoding(value));
+        }
+    }
+    return pairs.join("&");
+}
+
+FormReplay::FormReplay(QObject* parent, WebPage* webpage)
+    : QObject(parent)
+    , m_webpage(webpage)
+    , m_timer(new QTimer(this))
+    , m_draining(false)
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, SIGNAL(timeout()), SLOT(onTimeout()));
+}
+
+QList<QUrlQuery> FormReplay::variants(const QVariantMap& fields, int max)
+{
+    QList<FormField> form;
+    bool submitter = false;
+
+    QMapIterator<QString, QVariant> i(fields);
+    while (i.hasNext()) {
+        i.next();
+        FormField field;
+        field.name = i.key();
+        if (field.name.isEmpty()) {
+            continue;
+        }
+        QStringList choices;        // select options, radios, submit buttons
+        QString chosen;
+        QStringList checkboxes;
+        QStringList checked;
+        bool selectable = false;
+
+        foreach (const QVariant& control, i.value().toList()) {
+            QVariantMap attrs = control.toMap();
+            QString tag = attrs.value("tagName").toString().toLower();
+            QString type = attrs.value("type").toString().toLower();
+            QString value = attrs.value("value").toString();
+            if (attrs.contains("disabled")) {
+                continue;
+            }
+            if (tag == "option" || type == "radio") {
+                choices << value;
+                selectable = selectable || tag == "option";
+                if (chosen.isNull() && (attrs.contains("selected") || attrs.contains("checked"))) {
+                    chosen = value;
+                }
+            } else if (type == "checkbox") {
+                value = attrs.contains("value") ? value : "on";
+                checkboxes << value;
+                if (attrs.contains("checked")) {
+                    checked << value;
+                }
+            } else if (type == "submit" || type == "image" || (tag == "button" && type.isEmpty())) {
+                // only the button that submits the form is sent
+                if (!submitter) {
+                    choices << value;
+                    chosen = value;
+                    submitter = true;
+                }
+            } else if (type == "reset" || type == "button" || type == "file") {
+                continue;
+            } else if (type == "hidden" || !value.isEmpty()) {
+                field.values << value;
+            } else {
+                field.values << sample_value(type);
+            }
+        }
+
+        // a select sends its first option when none is selected, radios nothing
+        if (chosen.isNull() && selectable && !choices.isEmpty()) {
+            chosen = choices.first();
+        }
+        if (!chosen.isNull()) {
+            field.values << chosen;
+        }
+        field.values << checked;
+        foreach (QString choice, choices) {
+            if (choice != chosen) {
+                field.alternatives << (QStringList() << choice);
+            }
+        }
+        if (checkboxes != checked) {
+            field.alternatives << checkboxes;
+        }
+        if (!checked.isEmpty()) {
+            field.alternatives << QStringList();
+        }
+        if (!field.values.isEmpty() || !field.alternatives.isEmpty()) {
+            form << field;
+        }
+    }
+
+    // defaults first, then one field changed at a time
+    QStringList bodies;
+    QSet<QString> seen;
+    bodies << encode(form);
+    for (int f = 0; f < form.size(); ++f) {
+        foreach (QStringList values, form.at(f).alternatives) {
+            bodies << encode(form, f, values);
+        }
+    }
+
+    QList<QUrlQuery> result;
+    foreach (QString body, bodies) {
+        if (max > 0 && result.size() >= max) {
+            break;
+        }
+        if (!seen.contains(body)) {
+            seen.insert(body);
+            result << QUrlQuery(body);
+        }
+    }
+    return result;
+}
+
+QString FormReplay::submit(const QString& action, const QString& method, const QUrlQuery& query)
+{
+    static long int count = 0;
+    QString id = "form_replay_" + QString::number(++count);
+
+    QUrl url(action);
+    QByteArray verb = method.compare("post", Qt::CaseInsensitive) == 0 ? "POST" : "GET";
+    QByteArray body;
+    if (verb == "POST") {
+        body = query.toString(QUrl::FullyEncoded).toUtf8();
+    } else {
+        url.setQuery(query);
+    }
+    QNetworkRequest request(url);
+    if (verb == "POST") {
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+    }
+
+    QVariantMap record;
+    record["id"] = id;
+    record["type"] = "form_replay";
+    record["uri"] = url.toString();
+    record["method"] = QString(verb);
+    if (!body.isEmpty()) {
+        record["body"] = QString::fromUtf8(body);
+    }
+
+    m_webpage->setRequestTag(id);
+    QNetworkReply* reply = m_webpage->sendRequest(request, verb, body);
+    m_webpage->setRequestTag(QVariant());
+
+    m_pending[reply] = record;
+    if (reply->isFinished()) {
+        // refused before it started (blocked host, local file)
+        finish(reply);
+    } else {
+        connect(reply, SIGNAL(finished()), SLOT(onFinished()));
+    }
+    return id;
+}
+
+void FormReplay::drain(int timeout)
+{
+    if (m_pending.isEmpty()) {
+        emit done();
+        return;
+    }
+    m_draining = true;
+    m_timer->start(timeout);
+}
+
+// private slots:
+void FormReplay::onFinished()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (reply) {
+        finish(reply);
+    }
+}
+
+void FormReplay::onTimeout()
+{
+    foreach (QNetworkReply* reply, m_pending.keys()) {
+        qDebug() << "FormReplay - timeout" << m_pending.value(reply).value("uri").toString();
+        reply->abort();
+        // in case the abort did not finish it
+        finish(reply);
+    }
+}
+
+// private:
+void FormReplay::finish(QNetworkReply* reply)
+{
+    if (!m_pending.contains(reply)) {
+        return;
+    }
+    QVariantMap record = m_pending.take(reply);
+    record["status"] = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute);
+    record["contentType"] = reply->header(QNetworkRequest::ContentTypeHeader);
+    record["redirectURL"] = reply->header(QNetworkRequest::LocationHeader);
+    if (reply->error() != QNetworkReply::NoError) {
+        record["error"] = reply->errorString();
+    }
+    emit replayed(record);
+
+    if (m_draining && m_pending.isEmpty()) {
+        m_draining = false;
+        m_timer->stop();
+        emit done();
+    }
+}
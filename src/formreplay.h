@@ -0,0 +1,65 @@
+#ifndef FORMREPLAY_H
+#define FORMREPLAY_H
+
+#include <QHash>
+#include <QObject>
+#include <QUrlQuery>
+#include <QVariantMap>
+
+class QNetworkReply;
+class QTimer;
+class WebPage;
+
+/**
+ * Submits the forms DOMParser found straight through the page's network
+ * access manager (its cookies, headers and proxy), without loading the
+ * response into WebKit.
+ *
+ * variants() turns the static fields of a form (staticParserForm) into
+ * request bodies: the defaults a browser would send, then one variant per
+ * other select option / radio value and all / no checkboxes of a name.
+ * Empty text fields get a sample value for their input type.
+ *
+ * Requests carry the "form_replay_N" initiator; request and response
+ * records reach the page's resource signals like any other load, and
+ * replayed() reports each submission with its status. Nothing waits for
+ * the responses here, drain() tells when they are all in.
+ */
+class FormReplay : public QObject
+{
+    Q_OBJECT
+public:
+    FormReplay(QObject* parent, WebPage* webpage);
+
+    static QList<QUrlQuery> variants(const QVariantMap& fields, int max);
+
+    /**
+     * Send one variant, GET in the query string or POST url-encoded.
+     * @return the id of the submission
+     */
+    QString submit(const QString& action, const QString& method, const QUrlQuery& query);
+
+    /**
+     * Abort the submissions still running after `timeout` ms. done() is
+     * emitted once none is left, at once when none is running.
+     */
+    void drain(int timeout);
+
+signals:
+    void replayed(const QVariant& record);
+    void done();
+
+private slots:
+    void onFinished();
+    void onTimeout();
+
+private:
+    void finish(QNetworkReply* reply);
+
+    WebPage* m_webpage;
+    QHash<QNetworkReply*, QVariantMap> m_pending;
+    QTimer* m_timer;
+    bool m_draining;
+};
+
+#endif // FORMREPLAY_H
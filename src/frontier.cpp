@@ -0,0 +1,259 @@
+#include "frontier.h"
+
+#include <QDebug>
+#include <QHostAddress>
+
+#include "config.h"
+
+Frontier::Frontier(QObject* parent, Config* config)
+    : QObject(parent)
+    , m_scope(ScopeHost)
+    , m_maxDepth(config->crawlDepth())
+    , m_maxPages(config->crawlMaxPages())
+    , m_size(0)
+    , m_scheduled(0)
+{
+    if (config->crawlScope() == "domain") {
+        m_scope = ScopeDomain;
+    } else if (config->crawlScope() == "all") {
+        m_scope = ScopeAll;
+    }
+    if (!config->crawlInclude().isEmpty()) {
+        m_include.setPattern(config->crawlInclude());
+    }
+    if (!config->crawlExclude().isEmpty()) {
+        m_exclude.setPattern(config->crawlExclude());
+    }
+    if (!config->seenFile().isEmpty()) {
+        QString error;
+        if (!m_seen.attach(config->seenFile(), config->seenCapacity(), &error)) {
+            qWarning() << "Frontier - can not use seen file" << config->seenFile() << ":" << error;
+        }
+    }
+}
+
+bool Frontier::addSeed(const QString& url)
+{
+    QUrl normalized = normalize(url);
+    if (normalized.isEmpty()) {
+        return false;
+    }
+    // seeds define the scope, they are not filtered by it
+    m_hosts.insert(normalized.host());
+    m_domains.insert(registrableDomain(normalized.host()));
+
+    // a recrawl loads its seeds again, only the links are skipped
+    QString key = normalized.toString(QUrl::FullyEncoded);
+    if (!m_seen.insert(key.toUtf8(), false)) {
+        return false;
+    }
+
+    QVariantMap job;
+    job["url"] = url;
+    job["depth"] = 0;
+    enqueue(job);
+    return true;
+}
+
+bool Frontier::add(const QString& url, int depth, const QString& referrer)
+{
+    if (depth > m_maxDepth) {
+        return false;
+    }
+
+    QUrl normalized = normalize(url);
+    if (normalized.isEmpty() || !inScope(normalized)) {
+        return false;
+    }
+
+    QString key = normalized.toString(QUrl::FullyEncoded);
+    if (!m_seen.insert(key.toUtf8())) {
+        return false;
+    }
+
+    QVariantMap job;
+    job["url"] = key;
+    job["depth"] = depth;
+    job["referrer"] = referrer;
+    enqueue(job);
+    return true;
+}
+
+int Frontier::addLinks(const QVariantMap& record)
+{
+    int depth = record.value("depth").toInt() + 1;
+    if (depth > m_maxDepth) {
+        return 0;
+    }
+
+    QString referrer = record.value("url").toString();
+    int added = 0;
+    QMapIterator<QString, QVariant> i(record.value("data").toMap());
+    while (i.hasNext()) {
+        i.next();
+        QVariantMap link = i.value().toMap().value("dom_parser").toMap();
+        if (link.isEmpty() || !isFollowable(link)) {
+            continue;
+        }
+        if (add(link.value("uri").toString(), depth, referrer)) {
+            added++;
+        }
+    }
+
+    qDebug() << "Frontier -" << added << "new URL(s) from" << referrer << ", queued:" << m_size;
+    return added;
+}
+
+bool Frontier::isEmpty() const
+{
+    return m_size == 0 || (m_maxPages > 0 && m_scheduled >= m_maxPages);
+}
+
+int Frontier::size() const
+{
+    return m_size;
+}
+
+int Frontier::scheduled() const
+{
+    return m_scheduled;
+}
+
+QVariantMap Frontier::next()
+{
+    if (isEmpty()) {
+        return QVariantMap();
+    }
+
+    QMap<int, QQueue<QVariantMap> >::iterator it = m_queues.begin();
+    while (it.value().isEmpty()) {
+        it = m_queues.erase(it);
+    }
+
+    QVariantMap job = it.value().dequeue();
+    m_size--;
+    m_scheduled++;
+    return job;
+}
+
+QVariantMap Frontier::state() const
+{
+    QVariantList queue;
+    QMapIterator<int, QQueue<QVariantMap> > i(m_queues);
+    while (i.hasNext()) {
+        i.next();
+        foreach (const QVariantMap& job, i.value()) {
+            queue << job;
+        }
+    }
+
+    QVariantMap state;
+    state["queue"] = queue;
+    state["hosts"] = QStringList(m_hosts.toList());
+    state["domains"] = QStringList(m_domains.toList());
+    state["scheduled"] = m_scheduled;
+    return state;
+}
+
+void Frontier::restore(const QVariantMap& state)
+{
+    foreach (const QVariant& job, state.value("queue").toList()) {
+        enqueue(job.toMap());
+    }
+    foreach (const QString& host, state.value("hosts").toStringList()) {
+        m_hosts.insert(host);
+    }
+    foreach (const QString& domain, state.value("domains").toStringList()) {
+        m_domains.insert(domain);
+    }
+    m_scheduled = state.value("scheduled").toInt();
+}
+
+SeenSet& Frontier::seen()
+{
+    return m_seen;
+}
+
+// private:
+void Frontier::enqueue(const QVariantMap& job)
+{
+    // breadth first, static looking URLs before query URLs of the same depth
+    int priority = job.value("depth").toInt() * 2 + (QUrl(job.value("url").toString()).hasQuery() ? 1 : 0);
+    m_queues[priority].enqueue(job);
+    m_size++;
+}
+
+QUrl Frontier::normalize(const QString& url) const
+{
+    QUrl result(url.trimmed());
+    QString scheme = result.scheme().toLower();
+    if (!result.isValid() || result.host().isEmpty() || (scheme != "http" && scheme != "https")) {
+        return QUrl();
+    }
+
+    if ((scheme == "http" && result.port() == 80) || (scheme == "https" && result.port() == 443)) {
+        result.setPort(-1);
+    }
+    if (result.path().isEmpty()) {
+        result.setPath("/");
+    }
+    return result.adjusted(QUrl::RemoveFragment | QUrl::NormalizePathSegments);
+}
+
+bool Frontier::inScope(const QUrl& url) const
+{
+    switch (m_scope) {
+    case ScopeHost:
+        if (!m_hosts.contains(url.host())) {
+            return false;
+        }
+        break;
+    case ScopeDomain:
+        if (!m_domains.contains(registrableDomain(url.host()))) {
+            return false;
+        }
+        break;
+    case ScopeAll:
+        break;
+    }
+
+    QString text = url.toString(QUrl::FullyEncoded);
+    if (!m_include.pattern().isEmpty() && !m_include.match(text).hasMatch()) {
+        return false;
+    }
+    if (!m_exclude.pattern().isEmpty() && m_exclude.match(text).hasMatch()) {
+        return false;
+    }
+    return true;
+}
+
+bool Frontier::isFollowable(const QVariantMap& link)
+{
+    // documents only: images, scripts, media and styles are resources of a page
+    QString tag = link.value("tag_name").toString().toLower();
+    if (tag != "a" && tag != "area" && tag != "frame" && tag != "iframe" && tag != "form") {
+        return false;
+    }
+    // forms with a body are replayed by DOMParser, not crawled
+    return link.value("method").toString().compare("GET", Qt::CaseInsensitive) == 0
+        && !link.contains("body");
+}
+
+QString Frontier::registrableDomain(const QString& host)
+{
+    if (!QHostAddress(host).isNull()) {
+        return host;
+    }
+
+    // no public suffix list here: treat "xx.yy" second level names of a
+    // country code (com.cn, co.uk, ...) as the suffix
+    QStringList labels = host.split('.', QString::SkipEmptyParts);
+    int keep = 2;
+    if (labels.size() >= 3 && labels.last().length() == 2 && labels.at(labels.size() - 2).length() <= 3) {
+        keep = 3;
+    }
+    if (labels.size() <= keep) {
+        return host;
+    }
+    return QStringList(labels.mid(labels.size() - keep)).join('.');
+}
@@ -0,0 +1,85 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+#include <QObject>
+#include <QMap>
+#include <QQueue>
+#include <QRegularExpression>
+#include <QSet>
+#include <QUrl>
+#include <QVariantMap>
+
+#include "seenset.h"
+
+class Config;
+
+/**
+ * Crawl frontier ('--crawl-depth').
+ *
+ * Seeds and the links DOMParser::submit_uri reports for every crawled page
+ * are filtered by scope ('--crawl-scope', '--crawl-include',
+ * '--crawl-exclude'), limited by depth and '--crawl-max-pages', deduplicated
+ * on their normalized URL (a SeenSet, persisted with '--seen-file') and
+ * handed out as page pool jobs:
+ * { "url", "depth", "referrer" }.
+ *
+ * Shallow URLs go first (breadth first), and within one depth URLs
+ * without a query string go before those with one.
+ */
+class Frontier : public QObject
+{
+    Q_OBJECT
+public:
+    enum Scope { ScopeHost, ScopeDomain, ScopeAll };
+
+    Frontier(QObject* parent, Config* config);
+
+    bool addSeed(const QString& url);
+    bool add(const QString& url, int depth, const QString& referrer);
+
+    /**
+     * Queue the followable links found in a finished job record
+     * (see HtmlLoader::result()).
+     * @return number of new URLs
+     */
+    int addLinks(const QVariantMap& record);
+
+    bool isEmpty() const;
+    int size() const;
+    int scheduled() const;
+
+    /**
+     * @return the next job, or an empty map when the frontier is empty or
+     * '--crawl-max-pages' has been reached
+     */
+    QVariantMap next();
+
+    /**
+     * Checkpoint support: queue, scope and counters as a JSON friendly map,
+     * the seen set is saved separately (see SeenSet::save()).
+     */
+    QVariantMap state() const;
+    void restore(const QVariantMap& state);
+    SeenSet& seen();
+
+private:
+    void enqueue(const QVariantMap& job);
+    QUrl normalize(const QString& url) const;
+    bool inScope(const QUrl& url) const;
+    static bool isFollowable(const QVariantMap& link);
+    static QString registrableDomain(const QString& host);
+
+    Scope m_scope;
+    int m_maxDepth;
+    int m_maxPages;
+    QRegularExpression m_include;
+    QRegularExpression m_exclude;
+    QSet<QString> m_hosts;
+    QSet<QString> m_domains;
+    SeenSet m_seen;
+    QMap<int, QQueue<QVariantMap> > m_queues;
+    int m_size;
+    int m_scheduled;
+};
+
+#endif // FRONTIER_H
@@ -1,5 +1,7 @@
 #include "htmlloader.h"
 #include "bradypod.h"
+#include "bodystore.h"
+#include "dnscache.h"
 #include "terminal.h"
 
 #include <QJsonObject>
@@ -12,6 +14,9 @@ HtmlLoader::HtmlLoader(QObject *parent, WebPage *page)
     : QObject(parent)
     , m_webpage(0)
     , m_domparser(0)
+    , m_state(Idle)
+    , m_loadStarted(false)
+    , m_deferParsing(false)
 {
     m_bradypod = Bradypod::instance();
     if (page)
@@ -30,11 +35,13 @@ HtmlLoader::HtmlLoader(QObject *parent, WebPage *page)
     connect(m_webpage,SIGNAL(javaScriptConsoleMessageSent(QString)),SLOT(on_javaScriptConsoleMessageSent(QString)));
 
     connect(m_webpage,SIGNAL(loadStarted()),SLOT(on_loadStarted()));
+    connect(m_webpage,SIGNAL(settleStarted()),SLOT(on_settleStarted()));
     connect(m_webpage,SIGNAL(loadFinished(QString)),SLOT(on_loadFinished(QString)));
     connect(m_webpage,SIGNAL(urlChanged(QString)),SLOT(on_urlChanged(QString)));
 
     m_domparser = new DOMParser(this,m_webpage);
     connect(m_domparser,SIGNAL(parsedLinks(QVariant)),SLOT(on_parsedLink(QVariant)));
+    connect(m_domparser,SIGNAL(replayFinished()),SLOT(on_replayFinished()));
 }
 
 void HtmlLoader::loadUrl(const QUrl& url)
@@ -44,7 +51,17 @@ void HtmlLoader::loadUrl(const QUrl& url)
 
 void HtmlLoader::loadUrl(const QString& url)
 {
-    m_webpage->openUrl(url,m_bradypod->config()->getOperation(),m_bradypod->defaultPageSettings());
+    loadUrl(url, m_bradypod->config()->getOperation(), m_bradypod->defaultPageSettings());
+}
+
+void HtmlLoader::loadUrl(const QString& url, const QVariantMap& operation, const QVariantMap& settings)
+{
+    reset();
+    m_url = url;
+    m_start_time = QDateTime::currentDateTime();
+    setState(Loading);
+    m_webpage->setAllowNetworkAccess(true);
+    m_webpage->openUrl(url,operation,settings);
 }
 
 WebPage* HtmlLoader::webpage(void)
@@ -52,52 +69,172 @@ WebPage* HtmlLoader::webpage(void)
     return m_webpage;
 }
 
+DOMParser* HtmlLoader::domparser(void)
+{
+    return m_domparser;
+}
+
+HtmlLoader::State HtmlLoader::state() const
+{
+    return m_state;
+}
+
+QString HtmlLoader::url() const
+{
+    return m_url;
+}
+
 QString HtmlLoader::getHtmlContent() const
 {
     return m_html;
 }
 
+void HtmlLoader::setDeferParsing(const bool value)
+{
+    m_deferParsing = value;
+}
+
+void HtmlLoader::addParsedData(const QVariant& data)
+{
+    QVariantMap dataMap = data.toMap();
+    QString id = dataMap["id"].toString();
+    if (!m_requestData.contains(id)) {
+        m_requestData[id] = QVariantMap();
+    }
+    QVariantMap req = m_requestData[id].toMap();
+    QString type = dataMap["type"].toString();
+    if (type == "finished")
+    {
+        if (req.contains("response")){
+            // keep the start of the response, with the body captured since
+            // stored and spilled bodies are only referenced (bodyRef, bodyFile)
+            QVariantMap response = req["response"].toMap();
+            bool stored = dataMap.contains("bodyRef") || dataMap.contains("bodyFile");
+            foreach (QString key, dataMap.keys()) {
+                if (key.startsWith("body") && !(stored && (key == "body" || key == "bodyBase64"))) {
+                    response[key] = dataMap[key];
+                }
+            }
+            req["response"] = response;
+            m_requestData[id] = req;
+            return;
+        } else {
+            type = "response";
+        }
+    }
+    dataMap.remove("id");
+    dataMap.remove("type");
+    dataMap.remove("stage");
+    if (dataMap.contains("bodyRef") || dataMap.contains("bodyFile")) {
+        dataMap["body"] = "";
+        dataMap.remove("bodyBase64");
+    }
+    qDebug()<<"type: "<< type;
+    req[type] = dataMap;
+    m_requestData[id] = req;
+}
+
+QVariantMap HtmlLoader::result() const
+{
+    QDateTime end_time = m_end_time.isValid() ? m_end_time : QDateTime::currentDateTime();
+
+    QVariantMap data;
+    data["url"] = m_url;
+    data["start_time"] = m_start_time.toString(Qt::ISODateWithMs);
+    data["end_time"] = end_time.toString(Qt::ISODateWithMs);
+    data["time_cost"] = m_start_time.msecsTo(end_time);
+    data["data"] = m_requestData;
+    data["cookiejar"] = m_webpage->cookieJar()->cookiesToMap();
+    data["page_content"] = m_html;
+    const Config* config = m_bradypod->config();
+    if (config->hasBlockedAddresses()) {
+        // DNS is only resolved for the address rules; the counters are
+        // totals since the process started, shared by every page
+        data["dns_totals"] = DnsCache::instance()->stats();
+    }
+    if (BodyStore::instance()->isOpen()) {
+        data["body_store"] = BodyStore::instance()->stats();
+    }
+
+    if (config->blockedIpAndDomains().isEmpty() && config->resourceFilter().isEmpty()) {
+        return data;
+    }
+
+    // requests refused by the block rules, per rule
+    QVariantMap blocked;
+    foreach (const QVariant& request, m_requestData) {
+        QString rule = request.toMap().value("error").toMap().value("blocked").toString();
+        if (!rule.isEmpty()) {
+            blocked[rule] = blocked.value(rule).toInt() + 1;
+        }
+    }
+    data["blocked"] = blocked;
+    return data;
+}
+
+void HtmlLoader::reset()
+{
+    m_url.clear();
+    m_html.clear();
+    m_requestData.clear();
+    m_start_time = QDateTime();
+    m_end_time = QDateTime();
+    m_loadStarted = false;
+    m_domparser->reset();
+    setState(Idle);
+}
+
+void HtmlLoader::setState(State state)
+{
+    if (m_state != state) {
+        m_state = state;
+        emit stateChanged(state);
+    }
+}
+
 #define printResource(data) qDebug()<<BLUE<<__FUNCTION__<<" :: "<<NONE<<QJsonDocument::fromVariant(data).toJson(QJsonDocument::Indented)
 
 void HtmlLoader::on_resourceRequested(const QVariant& data, QObject* jsNetworkRequest)
 {
     (void)jsNetworkRequest;
     printResource(data);
-    m_bradypod->addParsedData(data);
+    addParsedData(data);
 }
 
 void HtmlLoader::on_resourceReceived(const QVariant& data)
 {
     printResource(data);
-    m_bradypod->addParsedData(data);
+    addParsedData(data);
+    m_domparser->scan_response(data.toMap());
 }
 
 void HtmlLoader::on_resourceError(const QVariant& data)
 {
     (void)data;
     printResource(data);
-    m_bradypod->addParsedData(data);
+    addParsedData(data);
 }
 
 void HtmlLoader::on_resourceTimeout(const QVariant& data)
 {
     printResource(data);
-    m_bradypod->addParsedData(data);
+    addParsedData(data);
 }
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
 void HtmlLoader::on_resourceRedirect(const QVariant& data)
 {
     printResource(data);
-    m_bradypod->addParsedData(data);
+    addParsedData(data);
 }
 #endif
 
 void HtmlLoader::on_loadFinished(const QString& status)
 {
-    static long int count = 0;
-    if (count++ > 0) {
-        qDebug()<<tr("COUNT:: %1 :: LOAD FINISHED: %2\n").arg(QString::number(count),status);
+    // Only the first load of the requested URL counts: later navigations
+    // and late signals from the previous URL (batch mode) are ignored.
+    if (!m_loadStarted || (m_state != Loading && m_state != Settling)) {
+        qDebug()<<tr("IGNORED LOAD FINISHED: %1\n").arg(status);
         return;
     }
     qDebug()<<(tr("LOAD FINISHED: %1\n").arg(status));
@@ -111,16 +248,33 @@ void HtmlLoader::on_loadFinished(const QString& status)
 //        QCoreApplication::processEvents(QEventLoop::AllEvents, 100);
 //    }
 
-    m_bradypod->config()->setAllowNetworkAccess(false);
+    m_webpage->setAllowNetworkAccess(false);
 
     QString text = m_webpage->mainFrame()->toHtml();
     m_html = text;
 
+    if (m_deferParsing) {
+        emit loaded();
+    } else {
+        on_renderFinished();
+    }
+}
+
+void HtmlLoader::on_settleStarted()
+{
+    if (m_loadStarted && m_state == Loading) {
+        setState(Settling);
+    }
+}
+
+void HtmlLoader::parse()
+{
     on_renderFinished();
 }
 
 void HtmlLoader::on_renderFinished()
 {
+    setState(Parsing);
     QString image_path = m_bradypod->config()->renderImagePath();
 
     if (!image_path.isEmpty())
@@ -128,7 +282,18 @@ void HtmlLoader::on_renderFinished()
 
     m_domparser->parse_traversal_dom();
 
-    m_bradypod->exit(1);
+    // the form replay responses still belong to this record
+    setState(Emitting);
+    m_domparser->finish_replay();
+}
+
+void HtmlLoader::on_replayFinished()
+{
+    if (m_state != Emitting) {
+        return;
+    }
+    m_end_time = QDateTime::currentDateTime();
+    emit finished();
 }
 
 void HtmlLoader::on_loadProgress(int progress)
@@ -138,6 +303,9 @@ void HtmlLoader::on_loadProgress(int progress)
 
 void HtmlLoader::on_loadStarted()
 {
+    if (m_state == Loading) {
+        m_loadStarted = true;
+    }
     qDebug()<<(tr("Loading..."));
 }
 
@@ -175,5 +343,5 @@ void HtmlLoader::on_parsedLink(const QVariant& data)
 {
     QByteArray json = QJsonDocument::fromVariant(data).toJson(QJsonDocument::Indented);
     qDebug()<<"\t"<<BLUE<<"on_parsedLink :: "<<NONE<<json;
-    m_bradypod->addParsedData(data);
+    addParsedData(data);
 }
@@ -5,6 +5,7 @@
 #include <QWebElement>
 #include <QWebElementCollection>
 #include <QTimer>
+#include <QDateTime>
 
 #include "webpage.h"
 #include "bradypod.h"
@@ -16,14 +17,50 @@ class HtmlLoader : public QObject
 {
     Q_OBJECT
 public:
+    // Idle -> Loading -> Settling -> Parsing -> Emitting -> Idle
+    enum State { Idle, Loading, Settling, Parsing, Emitting };
+
     explicit HtmlLoader(QObject *parent, WebPage *page);
     void loadUrl(const QUrl& url);
     void loadUrl(const QString& url);
+    void loadUrl(const QString& url, const QVariantMap& operation, const QVariantMap& settings);
     WebPage* webpage(void);
+    DOMParser* domparser(void);
+
+    State state() const;
+    QString url() const;
 
     QString getHtmlContent() const;
 
+    /**
+     * When parsing is deferred the loader stops after the page has settled
+     * and emits loaded(); the owner then calls parse() when it sees fit.
+     * Used by the page pool to run DOM parsing of one page at a time.
+     * parse() returns once the DOM is parsed; form replay responses are
+     * collected in the Emitting state, finished() follows them.
+     */
+    void setDeferParsing(const bool value);
+    void parse();
+
+    void addParsedData(const QVariant& data);
+
+    /**
+     * Result record of the current (or last) URL:
+     * url, start_time, end_time, time_cost, data, cookiejar and page_content;
+     * with block rules also blocked (requests refused per rule) and, for
+     * address rules, dns_totals (DnsCache counters of the whole process).
+     */
+    QVariantMap result() const;
+
+    /**
+     * Forget everything collected for the previous URL so the same
+     * loader (and its WebPage) can be reused for the next one.
+     */
+    void reset();
+
 signals:
+    void stateChanged(int state);
+    void loaded();
     void finished();
 
 public slots:
@@ -35,6 +72,7 @@ public slots:
     void on_resourceRedirect(const QVariant& data);
 #endif
 
+    void on_settleStarted();
     void on_loadFinished(const QString& arg1);
     void on_renderFinished();
     void on_loadProgress(int progress);
@@ -44,16 +82,26 @@ public slots:
     void on_windowTitleChanged(const QString &title);
 
     void on_parsedLink(const QVariant& data);
+    void on_replayFinished();
 
     void on_javaScriptConsoleMessageSent(const QString& message);
     void on_javaScriptErrorSent(const QString& message);
     void on_javaScriptErrorSent(const QString& msg, int lineNumber, const QString& sourceID, const QString& stack);
 
 private:
+    void setState(State state);
+
     WebPage* m_webpage;
     Bradypod* m_bradypod;
     DOMParser* m_domparser;
+    State m_state;
+    QString m_url;
     QString m_html;
+    QVariantMap m_requestData;
+    QDateTime m_start_time;
+    QDateTime m_end_time;
+    bool m_loadStarted;
+    bool m_deferParsing;
 };
 
 #endif // HTMLLOADER_H
@@ -0,0 +1,255 @@
+#include "jobserver.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include "bradypod.h"
+#include "config.h"
+#include "pagepool.h"
+
+// a client that never sends a newline must not grow its buffer for ever
+static const int MAX_REQUEST_SIZE = 1024 * 1024;
+
+// options applied to the job's own request and page, the others configure
+// the whole process and can not change per job
+static const char* const JOB_OPTIONS[] = {
+    "url", "method", "body", "body-encoding", "header", "user-agent", "cookies", "cookiejar",
+    "load-images", "javascript-enable", "web-security", "local-to-remote-url-access", "resource-timeout", 0
+};
+
+static bool isJobOption(const QString& option)
+{
+    for (int i = 0; JOB_OPTIONS[i]; ++i) {
+        if (option == QLatin1String(JOB_OPTIONS[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+JobServer::JobServer(QObject* parent, PagePool* pool)
+    : QObject(parent)
+    , m_pool(pool)
+    , m_localServer(0)
+    , m_tcpServer(0)
+    , m_serial(0)
+{
+    connect(m_pool, SIGNAL(jobFinished(QVariantMap)), SLOT(onJobFinished(QVariantMap)));
+}
+
+bool JobServer::listen(const QString& address)
+{
+    bool isPort = false;
+    quint16 port = address.toUShort(&isPort);
+
+    if (isPort) {
+        m_tcpServer = new QTcpServer(this);
+        connect(m_tcpServer, SIGNAL(newConnection()), SLOT(onNewTcpConnection()));
+        // local callers only, there is no authentication
+        if (!m_tcpServer->listen(QHostAddress::LocalHost, port)) {
+            m_errorString = m_tcpServer->errorString();
+            return false;
+        }
+    } else {
+        m_localServer = new QLocalServer(this);
+        connect(m_localServer, SIGNAL(newConnection()), SLOT(onNewLocalConnection()));
+        // a socket file left behind by a killed server would block listen()
+        QLocalServer::removeServer(address);
+        if (!m_localServer->listen(address)) {
+            m_errorString = m_localServer->errorString();
+            return false;
+        }
+    }
+
+    qDebug() << "JobServer - listening on" << address;
+    return true;
+}
+
+QString JobServer::errorString() const
+{
+    return m_errorString;
+}
+
+// private slots:
+void JobServer::onNewLocalConnection()
+{
+    while (m_localServer->hasPendingConnections()) {
+        addClient(m_localServer->nextPendingConnection());
+    }
+}
+
+void JobServer::onNewTcpConnection()
+{
+    while (m_tcpServer->hasPendingConnections()) {
+        addClient(m_tcpServer->nextPendingConnection());
+    }
+}
+
+void JobServer::onReadyRead()
+{
+    QIODevice* client = qobject_cast<QIODevice*>(sender());
+    if (!client) {
+        return;
+    }
+
+    QByteArray& buffer = m_buffers[client];
+    buffer.append(client->readAll());
+
+    int pos;
+    while ((pos = buffer.indexOf('\n')) >= 0) {
+        QByteArray line = buffer.left(pos).trimmed();
+        buffer.remove(0, pos + 1);
+        if (!line.isEmpty()) {
+            handleRequest(client, line);
+        }
+    }
+
+    if (buffer.size() > MAX_REQUEST_SIZE) {
+        qDebug() << "JobServer - request over" << MAX_REQUEST_SIZE << "bytes, closing the connection";
+        buffer.clear();
+        QVariantMap data;
+        data["error"] = QString("Job too large, the limit is %1 bytes").arg(MAX_REQUEST_SIZE);
+        reply(client, data);
+        client->close();
+    }
+}
+
+void JobServer::onDisconnected()
+{
+    QIODevice* client = qobject_cast<QIODevice*>(sender());
+    if (!client) {
+        return;
+    }
+    // jobs already queued still run, their results are dropped
+    m_buffers.remove(client);
+    client->deleteLater();
+}
+
+void JobServer::onJobFinished(const QVariantMap& record)
+{
+    int serial = record.value("serial").toInt();
+    if (!m_clients.contains(serial)) {
+        return;
+    }
+
+    QPointer<QIODevice> client = m_clients.take(serial);
+    if (client.isNull()) {
+        return;
+    }
+
+    QVariantMap data(record);
+    data.remove("serial");
+    reply(client, data);
+}
+
+// private:
+void JobServer::addClient(QIODevice* client)
+{
+    connect(client, SIGNAL(readyRead()), SLOT(onReadyRead()));
+    connect(client, SIGNAL(disconnected()), SLOT(onDisconnected()));
+    m_buffers[client] = QByteArray();
+}
+
+void JobServer::handleRequest(QIODevice* client, const QByteArray& line)
+{
+    QJsonParseError parseError;
+    QJsonDocument doc = QJsonDocument::fromJson(line, &parseError);
+    if (!doc.isObject()) {
+        QVariantMap data;
+        data["error"] = QString("Invalid job: %1").arg(parseError.errorString());
+        reply(client, data);
+        return;
+    }
+
+    QVariantMap request = doc.object().toVariantMap();
+    QString error;
+    QVariantMap job = makeJob(request, error);
+    if (!error.isEmpty()) {
+        QVariantMap data;
+        if (request.contains("id")) {
+            data["id"] = request.value("id");
+        }
+        data["error"] = error;
+        reply(client, data);
+        return;
+    }
+
+    job["serial"] = ++m_serial;
+    m_clients[m_serial] = client;
+    m_pool->enqueue(job);
+}
+
+QVariantMap JobServer::makeJob(const QVariantMap& request, QString& error) const
+{
+    // per job options are parsed on top of the server's own command line
+    QStringList args = QApplication::arguments();
+    foreach (const QVariant& arg, request.value("args").toList()) {
+        QString value = arg.toString();
+        if (value.startsWith('-')) {
+            QString option = value.mid(value.startsWith("--") ? 2 : 1).section('=', 0, 0);
+            if (!isJobOption(option)) {
+                error = QString("Option '%1' can not be set per job").arg(option);
+                return QVariantMap();
+            }
+        }
+        args << value;
+    }
+
+    Config config;
+    config.init(args);
+    if (!config.unknownOption().isEmpty()) {
+        error = config.unknownOption();
+        return QVariantMap();
+    }
+
+    QString url = request.value("url").toString();
+    if (url.isEmpty()) {
+        url = config.resourceUrl();
+    }
+    if (url.isEmpty()) {
+        error = "Missing 'url'";
+        return QVariantMap();
+    }
+
+    if (request.contains("method")) {
+        config.setMethod(request.value("method").toString());
+    }
+    if (request.contains("body")) {
+        config.setBody(request.value("body").toString());
+    }
+    QMapIterator<QString, QVariant> i(request.value("headers").toMap());
+    while (i.hasNext()) {
+        i.next();
+        config.addHeader(i.key(), i.value().toString());
+    }
+
+    QVariantMap job;
+    job["url"] = url;
+    job["operation"] = config.getOperation();
+    job["settings"] = Bradypod::instance()->pageSettings(&config);
+    job["cookies"] = config.cookies();
+    job["cookiejar_data"] = config.cookiejarData();
+    if (request.value("cookies").type() == QVariant::List) {
+        job["cookiejar_data"] = request.value("cookies");
+    } else if (request.contains("cookies")) {
+        job["cookies"] = request.value("cookies").toString();
+    }
+    job["commandline"] = args;
+    if (request.contains("id")) {
+        job["id"] = request.value("id");
+    }
+    return job;
+}
+
+void JobServer::reply(QIODevice* client, const QVariantMap& data)
+{
+    QJsonDocument doc(QJsonObject::fromVariantMap(data));
+    client->write(doc.toJson(QJsonDocument::Compact));
+    client->write("\n");
+}
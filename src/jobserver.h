@@ -0,0 +1,72 @@
+#ifndef JOBSERVER_H
+#define JOBSERVER_H
+
+#include <QObject>
+#include <QMap>
+#include <QPointer>
+#include <QVariantMap>
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+class PagePool;
+
+/**
+ * Job API of the resident process ('--serve').
+ *
+ * Listens on a unix socket path, or on 127.0.0.1 when the address is a
+ * port number. Clients send one JSON job per line:
+ * <pre>
+ * {
+ *   "id"      : "echoed back in the result (optional)",
+ *   "url"     : "URL to load",
+ *   "method"  : "GET, POST, ... (optional)",
+ *   "body"    : "request body (optional)",
+ *   "headers" : { "name": "value", ... } (optional),
+ *   "cookies" : "name=value; ..." or [ cookie maps ] (optional),
+ *   "args"    : [ "--load-images=false", ... ] (optional, command line options)
+ * }
+ * </pre>
+ * "args" may only hold options of the job's own request and page: url,
+ * method, body, body-encoding, header, user-agent, cookies, cookiejar,
+ * load-images, javascript-enable, web-security, local-to-remote-url-access
+ * and resource-timeout. The others are process wide, a job with one of
+ * them is refused with an "error" reply. So is a line over 1 MB, the
+ * connection is then closed.
+ *
+ * Jobs run on the shared page pool. Every result is written back on the
+ * same connection as one compact JSON line, in completion order, so a
+ * client may pipeline jobs and match results by "id".
+ */
+class JobServer : public QObject
+{
+    Q_OBJECT
+public:
+    JobServer(QObject* parent, PagePool* pool);
+
+    bool listen(const QString& address);
+    QString errorString() const;
+
+private slots:
+    void onNewLocalConnection();
+    void onNewTcpConnection();
+    void onReadyRead();
+    void onDisconnected();
+    void onJobFinished(const QVariantMap& record);
+
+private:
+    void addClient(QIODevice* client);
+    void handleRequest(QIODevice* client, const QByteArray& line);
+    QVariantMap makeJob(const QVariantMap& request, QString& error) const;
+    void reply(QIODevice* client, const QVariantMap& data);
+
+    PagePool* m_pool;
+    QLocalServer* m_localServer;
+    QTcpServer* m_tcpServer;
+    QString m_errorString;
+    QMap<QIODevice*, QByteArray> m_buffers;
+    QMap<int, QPointer<QIODevice> > m_clients;
+    int m_serial;
+};
+
+#endif // JOBSERVER_H
@@ -2,8 +2,13 @@
 #include "utils.h"
 #include "bradypod.h"
 #include "crashdump.h"
+#include "config.h"
+#ifdef Q_OS_UNIX
+#include "supervisor.h"
+#endif
 
 #include <QApplication>
+#include <QFontDatabase>
 #include <QtPlugin>
 #include <QSslSocket>
 #include <QWebSettings>
@@ -36,9 +41,41 @@ static int inner_main(int argc, char** argv)
     }
 #endif
 
+#ifdef Q_OS_UNIX
+    // Pre-forked workers: everything above is shared by the workers, the
+    // supervisor itself never creates a page
+    bool isWorker = false;
+    {
+        Config config;
+        config.init(app.arguments());
+        if (config.workers() > 0 && !config.urlList().isEmpty() && config.unknownOption().isEmpty()
+                && !config.helpFlag() && !config.versionFlag()) {
+            // warm up before fork, no WebKit thread may be running yet
+            QFontDatabase().families();
+            QWebSettings::globalSettings();
+
+            Supervisor supervisor(&config);
+            int retVal = supervisor.run();
+            if (!supervisor.isWorker()) {
+                return retVal;
+            }
+            isWorker = true;
+        }
+    }
+#endif
+
     // Get the bradypod singleton
     Bradypod* bradypod = Bradypod::instance();
 
+#ifdef Q_OS_UNIX
+    if (isWorker) {
+        // URLs come from the supervisor on stdin, records go back on stdout
+        bradypod->config()->setUrlList("-");
+        bradypod->config()->setOutputFile(QString());
+        bradypod->config()->setWorkers(0);
+    }
+#endif
+
     // Start script execution
     if (bradypod->execute()) {
         app.exec();
@@ -0,0 +1,67 @@
+#include "memorywatchdog.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <QWebSettings>
+
+#include "config.h"
+#include "utils.h"
+
+// WebCore's default total object cache capacity
+static const int DEFAULT_CACHE_CAPACITY = 32 * 1024 * 1024;
+// capacity restored first after it was halved down to nothing
+static const int MIN_CACHE_CAPACITY = 1024 * 1024;
+
+MemoryWatchdog::MemoryWatchdog(QObject* parent, Config* config)
+    : QObject(parent)
+    , m_softLimit(qint64(config->memorySoftLimit()) * 1024 * 1024)
+    , m_hardLimit(qint64(config->memoryHardLimit()) * 1024 * 1024)
+    , m_cacheCapacity(DEFAULT_CACHE_CAPACITY)
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(config->memoryCheckInterval());
+    connect(m_timer, SIGNAL(timeout()), SLOT(check()));
+}
+
+bool MemoryWatchdog::isEnabled() const
+{
+    return m_softLimit > 0 || m_hardLimit > 0;
+}
+
+void MemoryWatchdog::start()
+{
+    if (!isEnabled()) {
+        return;
+    }
+    if (Utils::residentMemory() < 0) {
+        qWarning() << "MemoryWatchdog - resident memory is not available on this platform";
+        return;
+    }
+    m_timer->start();
+}
+
+// private slots:
+void MemoryWatchdog::check()
+{
+    qint64 rss = Utils::residentMemory();
+
+    if (m_softLimit > 0 && rss > m_softLimit) {
+        m_cacheCapacity /= 2;
+        qDebug() << "MemoryWatchdog - resident memory" << rss / (1024 * 1024) << "MB over the soft limit,"
+                 << "object cache capacity" << m_cacheCapacity;
+        QWebSettings::setObjectCacheCapacities(0, m_cacheCapacity, m_cacheCapacity);
+        QWebSettings::clearMemoryCaches();
+        rss = Utils::residentMemory();
+    } else if (m_softLimit > 0 && m_cacheCapacity < DEFAULT_CACHE_CAPACITY && rss < m_softLimit / 10 * 9) {
+        // some headroom, or the capacity would swing on every sample
+        m_cacheCapacity = qMin(DEFAULT_CACHE_CAPACITY, qMax(MIN_CACHE_CAPACITY, m_cacheCapacity * 2));
+        qDebug() << "MemoryWatchdog - resident memory" << rss / (1024 * 1024) << "MB, object cache capacity restored to"
+                 << m_cacheCapacity;
+        QWebSettings::setObjectCacheCapacities(0, m_cacheCapacity, m_cacheCapacity);
+    }
+
+    if (m_hardLimit > 0 && rss > m_hardLimit) {
+        qWarning() << "MemoryWatchdog - resident memory" << rss / (1024 * 1024) << "MB over the hard limit";
+        emit hardLimitExceeded(rss);
+    }
+}
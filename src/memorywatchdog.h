@@ -0,0 +1,43 @@
+#ifndef MEMORYWATCHDOG_H
+#define MEMORYWATCHDOG_H
+
+#include <QObject>
+
+class QTimer;
+class Config;
+
+/**
+ * Samples the process resident memory every '--memory-check-interval' ms.
+ *
+ * Above '--memory-soft-limit' MB the WebKit memory caches are cleared and
+ * the object cache capacity is halved on every sample, down to no object
+ * cache at all. Once memory is back under 90% of the soft limit the
+ * capacity doubles on every sample, up to WebKit's default again.
+ *
+ * Above '--memory-hard-limit' MB hardLimitExceeded() is emitted, the
+ * owner aborts the pages in flight with a "memory_limit" result instead
+ * of waiting for the OOM killer.
+ */
+class MemoryWatchdog : public QObject
+{
+    Q_OBJECT
+public:
+    MemoryWatchdog(QObject* parent, Config* config);
+
+    bool isEnabled() const;
+    void start();
+
+signals:
+    void hardLimitExceeded(qint64 rss);
+
+private slots:
+    void check();
+
+private:
+    qint64 m_softLimit;
+    qint64 m_hardLimit;
+    int m_cacheCapacity;
+    QTimer* m_timer;
+};
+
+#endif // MEMORYWATCHDOG_H
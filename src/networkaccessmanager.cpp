@@ -10,12 +10,15 @@
 #include <QSslKey>
 #include <QRegExp>
 #include <QFile>
-#include <QHostInfo>
+#include <QHostAddress>
 
+#include "bodycapture.h"
 #include "bradypod.h"
 #include "config.h"
 #include "cookiejar.h"
+#include "dnscache.h"
 #include "networkaccessmanager.h"
+#include "requestscheduler.h"
 
 #include <private/qnetworkreplyhttpimpl_p.h>
 
@@ -71,6 +74,270 @@ NoFileAccessReply::NoFileAccessReply(QObject* parent, const QNetworkRequest& req
 NoFileAccessReply::~NoFileAccessReply() {}
 
 
+ScheduledReply::ScheduledReply(NetworkAccessManager* manager, const QNetworkRequest& req,
+                               const QNetworkAccessManager::Operation op, QIODevice* outgoingData, int priority)
+    : QNetworkReply(manager)
+    , m_manager(manager)
+    , m_outgoingData(outgoingData)
+    , m_host(req.url().host().toLower())
+    , m_priority(priority)
+    , m_started(false)
+    , m_released(false)
+    , m_ignoreSslErrors(false)
+    , m_schedule(true)
+{
+    setRequest(req);
+    setUrl(req.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly);
+}
+
+ScheduledReply::~ScheduledReply()
+{
+    if (!m_started) {
+        RequestScheduler::instance()->cancel(this);
+    } else if (!m_released) {
+        RequestScheduler::instance()->release(this);
+    }
+    if (m_reply) {
+        m_reply->disconnect(this);
+        m_reply->deleteLater();
+    }
+}
+
+QString ScheduledReply::host() const
+{
+    return m_host;
+}
+
+int ScheduledReply::priority() const
+{
+    return m_priority;
+}
+
+bool ScheduledReply::isStarted() const
+{
+    return m_started;
+}
+
+void ScheduledReply::start()
+{
+    m_started = true;
+    m_reply = m_manager->createNetworkReply(operation(), request(), m_outgoingData);
+    emit started();
+    if (m_ignoreSslErrors) {
+        m_reply->ignoreSslErrors();
+    }
+
+    connect(m_reply, SIGNAL(metaDataChanged()), SLOT(onMetaDataChanged()));
+    connect(m_reply, SIGNAL(readyRead()), SLOT(onReadyRead()));
+    connect(m_reply, SIGNAL(finished()), SLOT(onFinished()));
+    connect(m_reply, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(onError(QNetworkReply::NetworkError)));
+    connect(m_reply, SIGNAL(sslErrors(QList<QSslError>)), SLOT(onSslErrors(QList<QSslError>)));
+    connect(m_reply, SIGNAL(downloadProgress(qint64,qint64)), SIGNAL(downloadProgress(qint64,qint64)));
+    connect(m_reply, SIGNAL(uploadProgress(qint64,qint64)), SIGNAL(uploadProgress(qint64,qint64)));
+#if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
+    connect(m_reply, SIGNAL(redirected(QUrl)), SIGNAL(redirected(QUrl)));
+#endif
+
+    // synchronous replies (cache, data: ...) are done already, report
+    // them once the caller had a chance to connect
+    if (m_reply->isFinished()) {
+        QMetaObject::invokeMethod(this, "onFinished", Qt::QueuedConnection);
+    }
+}
+
+void ScheduledReply::abort()
+{
+    if (m_started) {
+        if (m_reply) {
+            m_reply->abort();
+        }
+        return;
+    }
+
+    RequestScheduler::instance()->cancel(this);
+    fail(QCoreApplication::translate("QNetworkReply", "Operation canceled"));
+}
+
+void ScheduledReply::resolve(bool schedule)
+{
+    m_schedule = schedule;
+    m_held.start();
+    connect(DnsCache::instance(), SIGNAL(resolved(QString,QStringList)),
+            SLOT(onResolved(QString,QStringList)));
+    DnsCache::instance()->resolve(m_host);
+}
+
+void ScheduledReply::dispatch(bool schedule)
+{
+    m_schedule = schedule;
+    if (schedule) {
+        RequestScheduler::instance()->submit(this);
+    } else {
+        // never held a scheduler slot
+        m_released = true;
+        start();
+    }
+}
+
+void ScheduledReply::close()
+{
+    if (m_reply) {
+        m_reply->close();
+    }
+    QNetworkReply::close();
+}
+
+qint64 ScheduledReply::bytesAvailable() const
+{
+    return m_buffer.size() + QNetworkReply::bytesAvailable();
+}
+
+void ScheduledReply::ignoreSslErrors()
+{
+    m_ignoreSslErrors = true;
+    if (m_reply) {
+        m_reply->ignoreSslErrors();
+    }
+}
+
+// protected:
+qint64 ScheduledReply::readData(char* data, qint64 maxSize)
+{
+    if (m_buffer.isEmpty()) {
+        return isFinished() ? -1 : 0;
+    }
+    qint64 size = qMin<qint64>(maxSize, m_buffer.size());
+    memcpy(data, m_buffer.constData(), size);
+    m_buffer.remove(0, size);
+    return size;
+}
+
+void ScheduledReply::sslConfigurationImplementation(QSslConfiguration& configuration) const
+{
+    if (m_reply) {
+        configuration = m_reply->sslConfiguration();
+    }
+}
+
+// private slots:
+void ScheduledReply::onMetaDataChanged()
+{
+    copyMetaData();
+    emit metaDataChanged();
+}
+
+void ScheduledReply::onReadyRead()
+{
+    fetch();
+    emit readyRead();
+}
+
+void ScheduledReply::onFinished()
+{
+    if (isFinished()) {
+        return;
+    }
+    fetch();
+    copyMetaData();
+
+    if (!m_released) {
+        m_released = true;
+        RequestScheduler::instance()->release(this);
+    }
+
+    setFinished(true);
+    emit finished();
+}
+
+void ScheduledReply::onError(QNetworkReply::NetworkError code)
+{
+    setError(code, m_reply->errorString());
+    emit error(code);
+}
+
+void ScheduledReply::onSslErrors(const QList<QSslError>& errors)
+{
+    emit sslErrors(errors);
+}
+
+void ScheduledReply::onResolved(const QString& host, const QStringList& addresses)
+{
+    if (host != m_host) {
+        return;
+    }
+    DnsCache::instance()->disconnect(this);
+    DnsCache::instance()->held(m_held.elapsed());
+    if (isFinished()) {
+        // aborted meanwhile
+        return;
+    }
+
+    if (m_manager->isBlockedAddress(addresses)) {
+        setProperty("blocked", "domain");
+        fail(QCoreApplication::translate("QNetworkReply", "access deny"));
+    } else {
+        dispatch(m_schedule);
+    }
+}
+
+// private:
+void ScheduledReply::copyMetaData()
+{
+    static const QNetworkRequest::Attribute attributes[] = {
+        QNetworkRequest::HttpStatusCodeAttribute,
+        QNetworkRequest::HttpReasonPhraseAttribute,
+        QNetworkRequest::RedirectionTargetAttribute,
+        QNetworkRequest::ConnectionEncryptedAttribute,
+        QNetworkRequest::SourceIsFromCacheAttribute,
+        QNetworkRequest::HttpPipeliningWasUsedAttribute
+    };
+
+    if (!m_reply) {
+        return;
+    }
+    setUrl(m_reply->url());
+    foreach (const QNetworkReply::RawHeaderPair& header, m_reply->rawHeaderPairs()) {
+        setRawHeader(header.first, header.second);
+    }
+    for (size_t i = 0; i < sizeof(attributes) / sizeof(attributes[0]); ++i) {
+        QVariant value = m_reply->attribute(attributes[i]);
+        if (value.isValid()) {
+            setAttribute(attributes[i], value);
+        }
+    }
+}
+
+void ScheduledReply::fetch()
+{
+    if (!m_reply) {
+        return;
+    }
+    QByteArray data = m_reply->readAll();
+    if (!data.isEmpty()) {
+        m_buffer += data;
+        if (m_schedule) {
+            RequestScheduler::instance()->received(m_host, data.size());
+        }
+        m_manager->captureBody(this, data);
+    }
+}
+
+// finish without ever starting the real reply
+void ScheduledReply::fail(const QString& message)
+{
+    m_started = true;
+    m_released = true;
+
+    qRegisterMetaType<QNetworkReply::NetworkError>();
+    setError(OperationCanceledError, message);
+    setFinished(true);
+    emit error(OperationCanceledError);
+    emit finished();
+}
+
+
 TimeoutTimer::TimeoutTimer(QObject* parent)
     : QTimer(parent)
 {
@@ -129,6 +396,7 @@ NetworkAccessManager::NetworkAccessManager(QObject* parent, Config* config)
     : QNetworkAccessManager(parent)
     , m_config(config)
     , m_ignoreSslErrors(config->ignoreSslErrors())
+    , m_allowNetworkAccess(config->allowNetworkAccess())
     , m_authAttempts(0)
     , m_maxAuthAttempts(3)
     , m_resourceTimeout(30000)
@@ -155,6 +423,12 @@ NetworkAccessManager::NetworkAccessManager(QObject* parent, Config* config)
         prepareSslConfiguration(config);
     }
 
+    foreach (QString type, config->responseBodyTypes().split(";", QString::SkipEmptyParts)) {
+        if (type.trimmed() != "none") {
+            m_bodyTypes << QRegExp(type.trimmed(), Qt::CaseInsensitive, QRegExp::Wildcard);
+        }
+    }
+
     setLastAccessTime();
 
     connect(this, SIGNAL(authenticationRequired(QNetworkReply*, QAuthenticator*)), SLOT(provideAuthentication(QNetworkReply*, QAuthenticator*)));
@@ -277,6 +551,36 @@ void NetworkAccessManager::setLastAccessTime()
     m_last_access = QDateTime::currentDateTime();
 }
 
+bool NetworkAccessManager::allowNetworkAccess() const
+{
+    return m_allowNetworkAccess;
+}
+
+void NetworkAccessManager::setAllowNetworkAccess(const bool value)
+{
+    m_allowNetworkAccess = value;
+}
+
+QVariant NetworkAccessManager::requestTag() const
+{
+    return m_requestTag;
+}
+
+void NetworkAccessManager::setRequestTag(const QVariant& tag)
+{
+    m_requestTag = tag;
+}
+
+QNetworkReply* NetworkAccessManager::sendRequest(const QNetworkRequest& request, const QByteArray& method, const QByteArray& body)
+{
+    // createRequest() runs within get() / post()
+    bool allow = m_allowNetworkAccess;
+    m_allowNetworkAccess = true;
+    QNetworkReply* reply = method == "POST" ? post(request, body) : get(request);
+    m_allowNetworkAccess = allow;
+    return reply;
+}
+
 void NetworkAccessManager::setCookieJar(QNetworkCookieJar* cookieJar)
 {
     QNetworkAccessManager::setCookieJar(cookieJar);
@@ -365,6 +669,9 @@ QNetworkReply* NetworkAccessManager::createRequest(Operation op, const QNetworkR
     data["headers"] = headers;
     if (op == PostOperation) { data["postData"] = postData.data(); }
     data["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    if (m_requestTag.isValid()) {
+        data["initiator"] = m_requestTag;
+    }
 
     JsNetworkRequest jsNetworkRequest(&req, this);
 
@@ -374,19 +681,37 @@ QNetworkReply* NetworkAccessManager::createRequest(Operation op, const QNetworkR
     // The second half of this conditional must match
     // QNetworkAccessManager's own idea of what a local file URL is.
     QNetworkReply* reply;
-    bool blocked = isBlockDomainOrIP(url.host());
+    QString filtered = m_config->resourceFilter().match(req);
+    bool unresolved = false;
+    bool blocked = filtered.isEmpty() && isBlockDomainOrIP(url.host(), &unresolved);
 
     // reply action
     if (!m_config->localUrlAccessEnabled() &&
             (url.isLocalFile() || scheme == QLatin1String("qrc"))) {
         reply = new NoFileAccessReply(this, req, op);
-    } else if (blocked) {
+    } else if (blocked || !filtered.isEmpty()) {
         reply = new NoFileAccessReply(this, req, op);
-    } else if (m_config->allowNetworkAccess()) {
+        reply->setProperty("blocked", blocked ? QString("domain") : filtered);
+    } else if (m_allowNetworkAccess) {
         if (m_config->onlyLoadFirstRequest()) {
-            m_config->setAllowNetworkAccess(false);
+            m_allowNetworkAccess = false;
+        }
+        bool http = scheme == QLatin1String("http") || scheme == QLatin1String("https");
+        bool schedule = RequestScheduler::instance()->isEnabled() && http;
+        // the body is captured as ScheduledReply reads it
+        bool capture = !m_bodyTypes.isEmpty() && http;
+        if (unresolved || schedule || capture) {
+            ScheduledReply* scheduled = new ScheduledReply(this, req, op, outgoingData, requestPriority(req));
+            if (unresolved) {
+                // held until DnsCache answers, the block list needs the addresses
+                scheduled->resolve(schedule);
+            } else {
+                scheduled->dispatch(schedule);
+            }
+            reply = scheduled;
+        } else {
+            reply = QNetworkAccessManager::createRequest(op, req, outgoingData);
         }
-        reply = QNetworkAccessManager::createRequest(op, req, outgoingData);
     } else {
         reply = new NoFileAccessReply(this, req, op);
     }
@@ -403,7 +728,13 @@ QNetworkReply* NetworkAccessManager::createRequest(Operation op, const QNetworkR
         nt->data = data;
         nt->setInterval(m_resourceTimeout);
         nt->setSingleShot(true);
-        nt->start();
+        // time spent in the scheduler queue or the DNS hold does not count
+        ScheduledReply* held = qobject_cast<ScheduledReply*>(reply);
+        if (held && !held->isStarted()) {
+            connect(held, SIGNAL(started()), nt, SLOT(start()));
+        } else {
+            nt->start();
+        }
 
         connect(nt, SIGNAL(timeout()), this, SLOT(handleTimeout()));
     }
@@ -412,6 +743,9 @@ QNetworkReply* NetworkAccessManager::createRequest(Operation op, const QNetworkR
     connect(reply, &QNetworkReply::redirected, this, &NetworkAccessManager::handleRedirect);
 #endif
     connect(reply, &QNetworkReply::readyRead, this, &NetworkAccessManager::handleStarted);
+    if (!m_config->resourceFilter().isEmpty()) {
+        connect(reply, &QNetworkReply::metaDataChanged, this, &NetworkAccessManager::handleMetaDataChanged);
+    }
     connect(reply, &QNetworkReply::sslErrors, this, &NetworkAccessManager::handleSslErrors);
     connect(reply, static_cast<void(QNetworkReply::*)(QNetworkReply::NetworkError)>(&QNetworkReply::error), this, &NetworkAccessManager::handleNetworkError);
 
@@ -475,7 +809,8 @@ void NetworkAccessManager::handleStarted()
     data["redirectURL"] = reply->header(QNetworkRequest::LocationHeader);
     data["headers"] = headers;
     data["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
-    data["body"] = getResponseBodyFromReply(reply);
+    // captured replies report their whole body once finished
+    data["body"] = m_bodyTypes.isEmpty() ? getResponseBodyFromReply(reply) : QVariant("");
 
     emit resourceReceived(data);
 }
@@ -520,6 +855,11 @@ void NetworkAccessManager::handleFinished(QNetworkReply* reply, const QVariant&
     data["headers"] = headers;
     data["time"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
     data["body"] = "";
+    BodyCapture* body = m_bodies.take(reply);
+    if (body) {
+        body->fill(data);
+        delete body;
+    }
 
     m_ids.remove(reply);
     m_started.remove(reply);
@@ -559,10 +899,29 @@ void NetworkAccessManager::handleNetworkError(QNetworkReply::NetworkError error)
     data["errorString"] = reply->errorString();
     data["status"] = status;
     data["statusText"] = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute);
-    if(!status.isValid())
+    if (reply->property("blocked").isValid()) {
+        data["blocked"] = reply->property("blocked");
+    }
+    if(!status.isValid() || data.contains("blocked"))
         emit resourceError(data);
 }
 
+// streamed replies of a blocked Content-Type stop once the headers are in
+void NetworkAccessManager::handleMetaDataChanged()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply || reply->property("blocked").isValid()
+            || reply->request().rawHeader("Accept").contains("text/html")) {
+        return;
+    }
+    QString type = m_config->resourceFilter().matchContentType(reply->header(QNetworkRequest::ContentTypeHeader).toString());
+    if (!type.isEmpty()) {
+        qDebug() << "Network - blocked" << type << reply->url().toEncoded();
+        reply->setProperty("blocked", type);
+        reply->abort();
+    }
+}
+
 QVariantList NetworkAccessManager::getHeadersFromReply(const QNetworkReply* reply)
 {
     QVariantList headers;
@@ -669,30 +1028,78 @@ void NetworkAccessManager::setRequestHeaders(QNetworkRequest* request)
     }
 }
 
-bool NetworkAccessManager::isBlockDomainOrIP(const QString& domain)
+// `unresolved` is set when the addresses of `domain` are not cached yet,
+// the caller holds the request until DnsCache resolved it
+bool NetworkAccessManager::isBlockDomainOrIP(const QString& domain, bool* unresolved)
 {
-    bool blocked = false;
+    *unresolved = false;
     // check blocked domin list
-    if (m_config->hasSetBlockDomain()) {
-        blocked = m_config->isBlockedIpDomain(domain);
-        if (!blocked){
-            if (!m_dns_cache.contains(domain)) {
-                // FIXME: The function blocks during the lookup which means that execution of the program
-                // is suspended until the results of the lookup are ready.
-                const QList<QHostAddress>& hostAddresses = QHostInfo::fromName(domain).addresses();
-                foreach (QHostAddress host, hostAddresses) {
-                    m_dns_cache.insert(domain,host.toString());
-                }
-            }
-            // from cache
-            const QList<QString>& values = m_dns_cache.values(domain);
-            foreach (QString value, values) {
-                if (m_config->isBlockedIpDomain(value)) {
-                    blocked = true;
-                    break;
-                }
+    if (!m_config->hasSetBlockDomain() || domain.isEmpty()) {
+        return false;
+    }
+    if (m_config->isBlockedIpDomain(domain)) {
+        return true;
+    }
+    // resolved addresses only matter to IP / network rules
+    if (!m_config->hasBlockedAddresses() || !QHostAddress(domain).isNull()) {
+        return false;
+    }
+
+    QStringList addresses;
+    if (!DnsCache::instance()->lookup(domain.toLower(), &addresses)) {
+        *unresolved = true;
+        return false;
+    }
+    return isBlockedAddress(addresses);
+}
+
+bool NetworkAccessManager::isBlockedAddress(const QStringList& addresses) const
+{
+    foreach (const QString& address, addresses) {
+        if (m_config->isBlockedIpDomain(address)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// documents before their subresources, images last
+int NetworkAccessManager::requestPriority(const QNetworkRequest& request)
+{
+    QByteArray accept = request.rawHeader("Accept");
+    if (accept.contains("text/html")) {
+        return RequestScheduler::DocumentPriority;
+    }
+    if (accept.startsWith("image/")) {
+        return RequestScheduler::ImagePriority;
+    }
+    return RequestScheduler::SubresourcePriority;
+}
+
+QNetworkReply* NetworkAccessManager::createNetworkReply(Operation op, const QNetworkRequest& req, QIODevice* outgoingData)
+{
+    return QNetworkAccessManager::createRequest(op, req, outgoingData);
+}
+
+// whether a reply is captured is decided on its first chunk, the
+// Content-Type is known by then
+void NetworkAccessManager::captureBody(QNetworkReply* reply, const QByteArray& data)
+{
+    QHash<QNetworkReply*, BodyCapture*>::iterator body = m_bodies.find(reply);
+    if (body == m_bodies.end()) {
+        BodyCapture* capture = 0;
+        QString type = reply->header(QNetworkRequest::ContentTypeHeader).toString().section(';', 0, 0).trimmed();
+        foreach (const QRegExp& wc, m_bodyTypes) {
+            if (wc.exactMatch(type)) {
+                capture = new BodyCapture(qint64(m_config->responseBodyMemory()) * 1024,
+                                          qint64(m_config->responseBodyMaxSize()) * 1024,
+                                          m_config->responseBodyDir());
+                break;
             }
         }
+        body = m_bodies.insert(reply, capture);
+    }
+    if (body.value()) {
+        body.value()->append(data);
     }
-    return blocked;
 }
@@ -8,7 +8,11 @@
 #include <QStringList>
 #include <QMutex>
 #include <QDateTime>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QRegExp>
 
+class BodyCapture;
 class Config;
 class QAuthenticator;
 class QNetworkDiskCache;
@@ -54,6 +58,81 @@ protected:
 };
 
 
+class NetworkAccessManager;
+
+/**
+ * Stands in for a request that waits in the RequestScheduler, or for the
+ * DnsCache to resolve its host for the block list check. Once started it
+ * creates the real reply and forwards its meta data, data and signals.
+ */
+class ScheduledReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    ScheduledReply(NetworkAccessManager* manager, const QNetworkRequest& req,
+                   const QNetworkAccessManager::Operation op, QIODevice* outgoingData, int priority);
+    ~ScheduledReply();
+
+    QString host() const;
+    int priority() const;
+    bool isStarted() const;
+    void start();
+
+    /**
+     * Hold the request until its host is resolved, then refuse it when an
+     * address is blocked, or dispatch() it.
+     */
+    void resolve(bool schedule);
+
+    /**
+     * Submit the request to the scheduler (`schedule`) or start it now.
+     */
+    void dispatch(bool schedule);
+
+    void abort() Q_DECL_OVERRIDE;
+    void close() Q_DECL_OVERRIDE;
+    qint64 bytesAvailable() const Q_DECL_OVERRIDE;
+    bool isSequential() const Q_DECL_OVERRIDE { return true; }
+    void ignoreSslErrors() Q_DECL_OVERRIDE;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) Q_DECL_OVERRIDE;
+    void sslConfigurationImplementation(QSslConfiguration& configuration) const Q_DECL_OVERRIDE;
+
+signals:
+    /**
+     * The real reply was created, the request is on the network.
+     */
+    void started();
+
+private slots:
+    void onMetaDataChanged();
+    void onReadyRead();
+    void onFinished();
+    void onError(QNetworkReply::NetworkError code);
+    void onSslErrors(const QList<QSslError>& errors);
+    void onResolved(const QString& host, const QStringList& addresses);
+
+private:
+    void copyMetaData();
+    void fetch();
+    void fail(const QString& message);
+
+    NetworkAccessManager* m_manager;
+    QIODevice* m_outgoingData;
+    QPointer<QNetworkReply> m_reply;
+    QByteArray m_buffer;
+    QString m_host;
+    int m_priority;
+    bool m_started;
+    bool m_released;
+    bool m_ignoreSslErrors;
+    bool m_schedule;
+    QElapsedTimer m_held;
+};
+
+
 class NetworkAccessManager : public QNetworkAccessManager
 {
     Q_OBJECT
@@ -71,9 +150,27 @@ public:
 
     QDateTime getLastAccessTime();
 
+    bool allowNetworkAccess() const;
+    void setAllowNetworkAccess(const bool value);
+
+    /**
+     * Tag copied as "initiator" into the data of every request created
+     * while it is set, an invalid QVariant clears it.
+     */
+    QVariant requestTag() const;
+    void setRequestTag(const QVariant& tag);
+
+    /**
+     * GET or POST `request` outside of WebKit (form replay). It is sent even
+     * while network access is forbidden for the page's own loads.
+     */
+    QNetworkReply* sendRequest(const QNetworkRequest& request, const QByteArray& method, const QByteArray& body);
+
 protected:
     Config* m_config;
     bool m_ignoreSslErrors;
+    bool m_allowNetworkAccess;
+    QVariant m_requestTag;
     int m_authAttempts;
     int m_maxAuthAttempts;
     int m_resourceTimeout;
@@ -105,6 +202,7 @@ private slots:
     void handleSslErrors(const QList<QSslError>& errors);
     void handleNetworkError(QNetworkReply::NetworkError);
     void handleTimeout();
+    void handleMetaDataChanged();
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 6, 0)
     void handleRedirect(const QUrl& url);
@@ -114,7 +212,11 @@ private:
     void prepareSslConfiguration(const Config* config);
     QVariantList getHeadersFromReply(const QNetworkReply* reply);
     void setRequestHeaders(QNetworkRequest* request);
-    bool isBlockDomainOrIP(const QString& domain);
+    bool isBlockDomainOrIP(const QString& domain, bool* unresolved);
+    bool isBlockedAddress(const QStringList& addresses) const;
+    static int requestPriority(const QNetworkRequest& request);
+    QNetworkReply* createNetworkReply(Operation op, const QNetworkRequest& req, QIODevice* outgoingData);
+    void captureBody(QNetworkReply* reply, const QByteArray& data);
 
     QHash<QNetworkReply*, int> m_ids;
     QSet<QNetworkReply*> m_started;
@@ -123,7 +225,10 @@ private:
     QNetworkDiskCache* m_networkDiskCache;
     QVariantList m_customHeaders;
     QSslConfiguration m_sslConfiguration;
-    QMultiMap<QString,QString> m_dns_cache;
+    QList<QRegExp> m_bodyTypes;
+    QHash<QNetworkReply*, BodyCapture*> m_bodies;
+
+    friend class ScheduledReply;
 };
 
 #endif // NETWORKACCESSMANAGER_H
@@ -0,0 +1,293 @@
+#include "pagepool.h"
+
+#include <QDebug>
+#include <QTimer>
+#include <QWebFrame>
+
+#include "bradypod.h"
+#include "cookiejar.h"
+#include "htmlloader.h"
+#include "utils.h"
+#include "webpage.h"
+
+PagePool::PagePool(QObject* parent, int concurrency)
+    : QObject(parent)
+    , m_bradypod(Bradypod::instance())
+    , m_cookieJar(new CookieJar(QString(), this))
+    , m_sharedCookies(false)
+    , m_maxLoads(m_bradypod->config()->pageMaxLoads())
+    , m_maxMemory(qint64(m_bradypod->config()->pageMaxMemory()) * 1024 * 1024)
+    , m_parsing(false)
+    , m_dispatchScheduled(false)
+{
+    if (concurrency < 1) {
+        concurrency = 1;
+    }
+
+    for (int i = 0; i < concurrency; ++i) {
+        m_loaders.append(createSlot());
+    }
+}
+
+int PagePool::concurrency() const
+{
+    return m_loaders.size();
+}
+
+int PagePool::pending() const
+{
+    return m_queue.size();
+}
+
+int PagePool::active() const
+{
+    return m_running.size();
+}
+
+bool PagePool::isIdle() const
+{
+    return m_queue.isEmpty() && m_running.isEmpty();
+}
+
+QList<QVariantMap> PagePool::jobs() const
+{
+    QList<QVariantMap> jobs = m_running.values();
+    foreach (const QVariantMap& job, m_queue) {
+        jobs << job;
+    }
+    return jobs;
+}
+
+CookieJar* PagePool::cookieJar() const
+{
+    return m_cookieJar;
+}
+
+void PagePool::setSharedCookies(bool shared)
+{
+    m_sharedCookies = shared;
+}
+
+void PagePool::enqueue(const QVariantMap& job)
+{
+    if (job.value("url").toString().isEmpty()) {
+        return;
+    }
+    m_queue.enqueue(job);
+    scheduleDispatch();
+}
+
+void PagePool::enqueue(const QString& url)
+{
+    QVariantMap job;
+    job["url"] = url;
+    enqueue(job);
+}
+
+void PagePool::abort(const QString& error)
+{
+    foreach (HtmlLoader* loader, m_running.keys()) {
+        if (loader->state() == HtmlLoader::Parsing) {
+            m_aborted[loader] = error;
+            loader->webpage()->stop();
+            loader->webpage()->stopJavaScript();
+            continue;
+        }
+
+        qDebug() << "PagePool - abort job:" << loader->url() << error;
+        QVariantMap record = finishJob(loader);
+        record["error"] = error;
+        emit jobFinished(record);
+        retire(loader);
+    }
+    scheduleDispatch();
+}
+
+// private slots:
+void PagePool::dispatch()
+{
+    m_dispatchScheduled = false;
+
+    int idle = m_loaders.size() - m_running.size();
+    if (idle > m_queue.size()) {
+        emit jobsWanted(idle - m_queue.size());
+    }
+
+    foreach (HtmlLoader* loader, m_loaders) {
+        if (m_queue.isEmpty()) {
+            break;
+        }
+        if (m_running.contains(loader)) {
+            continue;
+        }
+        startJob(loader, m_queue.dequeue());
+    }
+
+    if (isIdle()) {
+        emit drained();
+    }
+}
+
+void PagePool::parseNext()
+{
+    if (m_parsing || m_parseQueue.isEmpty()) {
+        return;
+    }
+
+    HtmlLoader* loader = m_parseQueue.dequeue();
+    m_parsing = true;
+    loader->parse();
+    m_parsing = false;
+
+    if (!m_parseQueue.isEmpty()) {
+        QTimer::singleShot(0, this, SLOT(parseNext()));
+    }
+}
+
+void PagePool::onLoaded()
+{
+    HtmlLoader* loader = qobject_cast<HtmlLoader*>(sender());
+    if (!loader || !m_running.contains(loader)) {
+        return;
+    }
+    m_parseQueue.enqueue(loader);
+    QTimer::singleShot(0, this, SLOT(parseNext()));
+}
+
+void PagePool::onFinished()
+{
+    HtmlLoader* loader = qobject_cast<HtmlLoader*>(sender());
+    if (!loader || !m_running.contains(loader)) {
+        return;
+    }
+
+    QVariantMap record = finishJob(loader);
+    if (m_aborted.contains(loader)) {
+        record["error"] = m_aborted.value(loader);
+    }
+
+    emit jobFinished(record);
+
+    if (m_aborted.contains(loader) || shouldRetire(loader)) {
+        retire(loader);
+    } else {
+        loader->webpage()->stop();
+        loader->webpage()->clearHistory();
+        loader->reset();
+    }
+    scheduleDispatch();
+}
+
+// private:
+HtmlLoader* PagePool::createSlot()
+{
+    WebPage* page = static_cast<WebPage*>(m_bradypod->createWebPage());
+    // every slot gets its own cookies, jobs must not see each other's session
+    CookieJar* jar = new CookieJar(QString(), page);
+    page->setCookieJar(jar);
+
+    HtmlLoader* loader = new HtmlLoader(this, page);
+    m_jars[loader] = jar;
+    loader->setDeferParsing(true);
+    connect(loader, SIGNAL(loaded()), SLOT(onLoaded()));
+    connect(loader, SIGNAL(finished()), SLOT(onFinished()));
+    m_loads[loader] = 0;
+    return loader;
+}
+
+bool PagePool::shouldRetire(HtmlLoader* loader) const
+{
+    if (m_maxLoads > 0 && m_loads.value(loader) >= m_maxLoads) {
+        return true;
+    }
+    if (m_maxMemory > 0) {
+        qint64 rss = Utils::residentMemory();
+        if (rss > m_maxMemory) {
+            qDebug() << "PagePool - resident memory" << rss / (1024 * 1024) << "MB over the limit";
+            return true;
+        }
+    }
+    return false;
+}
+
+void PagePool::retire(HtmlLoader* loader)
+{
+    qDebug() << "PagePool - retire page after" << m_loads.value(loader) << "load(s)";
+
+    CookieJar* jar = m_jars.take(loader);
+    m_loads.remove(loader);
+    m_aborted.remove(loader);
+    m_parseQueue.removeAll(loader);
+    m_loaders[m_loaders.indexOf(loader)] = createSlot();
+
+    disconnect(loader, 0, this, 0);
+    WebPage* page = loader->webpage();
+    // same teardown as Bradypod::doExit: stop scripts, delete from the event loop
+    page->mainFrame()->setUrl(QUrl(QStringLiteral("about:blank")));
+    loader->deleteLater();
+    page->deleteLater();
+    // the network access manager hands its jar to Bradypod, it would outlive the page
+    jar->deleteLater();
+}
+
+QVariantMap PagePool::finishJob(HtmlLoader* loader)
+{
+    QVariantMap job = m_running.take(loader);
+    QVariantMap record = loader->result();
+    QMapIterator<QString, QVariant> i(job);
+    while (i.hasNext()) {
+        i.next();
+        if (!isLoadKey(i.key())) {
+            record[i.key()] = i.value();
+        }
+    }
+    m_loads[loader]++;
+    return record;
+}
+
+void PagePool::scheduleDispatch()
+{
+    if (!m_dispatchScheduled) {
+        m_dispatchScheduled = true;
+        QTimer::singleShot(0, this, SLOT(dispatch()));
+    }
+}
+
+void PagePool::startJob(HtmlLoader* loader, const QVariantMap& job)
+{
+    QString url = job.value("url").toString();
+    qDebug() << "PagePool - start job:" << url;
+
+    bool ownCookies = job.contains("cookies") || job.contains("cookiejar_data");
+    if (m_sharedCookies && !ownCookies) {
+        loader->webpage()->setCookieJar(m_cookieJar);
+        // the command line cookies once per site, the crawl may update them
+        if (m_cookieJar->cookiesForUrl(QUrl(url)).isEmpty()) {
+            m_bradypod->applyConfigCookies(m_cookieJar, url);
+        }
+    } else {
+        CookieJar* jar = m_jars.value(loader);
+        loader->webpage()->setCookieJar(jar);
+        jar->clearCookies();
+        if (ownCookies) {
+            m_bradypod->applyCookies(jar, url, job.value("cookies").toString(), job.value("cookiejar_data").toList());
+        } else {
+            m_bradypod->applyConfigCookies(jar, url);
+        }
+    }
+    loader->webpage()->switchToMainFrame();
+
+    QVariantMap operation = job.contains("operation") ? job.value("operation").toMap()
+                                                      : m_bradypod->config()->getOperation();
+    QVariantMap settings = job.contains("settings") ? job.value("settings").toMap()
+                                                    : m_bradypod->defaultPageSettings();
+
+    m_running[loader] = job;
+    loader->loadUrl(url, operation, settings);
+}
+
+bool PagePool::isLoadKey(const QString& key)
+{
+    return key == "url" || key == "operation" || key == "settings"
+        || key == "cookies" || key == "cookiejar_data";
+}
@@ -0,0 +1,112 @@
+#ifndef PAGEPOOL_H
+#define PAGEPOOL_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QQueue>
+#include <QVariantMap>
+
+class HtmlLoader;
+class Bradypod;
+class CookieJar;
+
+/**
+ * A fixed number of page slots (WebPage + HtmlLoader + DOMParser) driven by
+ * the main event loop.
+ *
+ * Jobs are queued and handed to idle slots. Every slot walks through
+ * loading -> settling -> parsing -> emitting and is then reset for the next
+ * job, so several loads are in flight while the process waits on the network.
+ * WebKit is single threaded and DOMParser spins the event loop while waiting
+ * for emulated clicks, so DOM parsing itself runs for one slot at a time.
+ *
+ * Slots are recycled instead of rebuilt for every URL: a WebPage (with its
+ * NetworkAccessManager and settings) is only retired and replaced after
+ * '--page-max-loads' jobs, or when the process resident memory is above
+ * '--page-max-memory' MB when one of its jobs finishes. Retiring bounds the
+ * WebKit heap growth and fragmentation of long runs.
+ *
+ * A job is a QVariantMap with at least an "url" entry. The optional entries
+ * "operation" (see WebPage::openUrl), "settings" (page settings), "cookies"
+ * (name=value; ...) and "cookiejar_data" (list of cookie maps) replace the
+ * command line values for this job. Every other key of the job is copied
+ * into the result record.
+ *
+ * Each job starts with a clean cookie jar of its slot, unless the cookies
+ * are shared (setSharedCookies(), url list and crawl runs): then the jobs
+ * without cookies of their own all use cookieJar(), the session of the
+ * crawl that checkpoints save.
+ */
+class PagePool : public QObject
+{
+    Q_OBJECT
+public:
+    PagePool(QObject* parent, int concurrency);
+
+    int concurrency() const;
+    int pending() const;
+    int active() const;
+    bool isIdle() const;
+
+    /**
+     * Jobs not finished yet: running ones first, then the queue.
+     */
+    QList<QVariantMap> jobs() const;
+
+    CookieJar* cookieJar() const;
+    void setSharedCookies(bool shared);
+
+public slots:
+    void enqueue(const QVariantMap& job);
+    void enqueue(const QString& url);
+
+    /**
+     * Give up the running jobs: each one finishes with an "error" entry
+     * and its slot is retired. A page in DOM parsing can not be torn down
+     * under DOMParser, it is stopped and finishes with the error.
+     */
+    void abort(const QString& error);
+
+signals:
+    /**
+     * Emitted when slots are idle and the queue can not feed them.
+     * Handlers may enqueue() synchronously.
+     */
+    void jobsWanted(int count);
+    void jobFinished(const QVariantMap& record);
+    void drained();
+
+private slots:
+    void dispatch();
+    void parseNext();
+    void onLoaded();
+    void onFinished();
+
+private:
+    HtmlLoader* createSlot();
+    bool shouldRetire(HtmlLoader* loader) const;
+    void retire(HtmlLoader* loader);
+    QVariantMap finishJob(HtmlLoader* loader);
+    void scheduleDispatch();
+    void startJob(HtmlLoader* loader, const QVariantMap& job);
+    static bool isLoadKey(const QString& key);
+
+    Bradypod* m_bradypod;
+    CookieJar* m_cookieJar;
+    bool m_sharedCookies;
+    QList<HtmlLoader*> m_loaders;
+    QHash<HtmlLoader*, CookieJar*> m_jars;
+    QQueue<QVariantMap> m_queue;
+    QMap<HtmlLoader*, QVariantMap> m_running;
+    QHash<HtmlLoader*, int> m_loads;
+    QHash<HtmlLoader*, QString> m_aborted;
+    int m_maxLoads;
+    qint64 m_maxMemory;
+    QQueue<HtmlLoader*> m_parseQueue;
+    bool m_parsing;
+    bool m_dispatchScheduled;
+};
+
+#endif // PAGEPOOL_H
@@ -0,0 +1,170 @@
+#include "requestscheduler.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QTimer>
+
+#include "networkaccessmanager.h"
+
+static RequestScheduler* scheduler_instance = 0;
+
+RequestScheduler* RequestScheduler::instance()
+{
+    if (!scheduler_instance) {
+        scheduler_instance = new RequestScheduler(QCoreApplication::instance());
+    }
+    return scheduler_instance;
+}
+
+RequestScheduler::RequestScheduler(QObject* parent)
+    : QObject(parent)
+    , m_maxConnections(0)
+    , m_delay(0)
+    , m_bandwidth(0)
+{
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    connect(m_timer, SIGNAL(timeout()), SLOT(pump()));
+}
+
+void RequestScheduler::setLimits(int maxConnections, int delay, int bandwidth)
+{
+    m_maxConnections = qMax(0, maxConnections);
+    m_delay = qMax(0, delay);
+    m_bandwidth = qMax(0, bandwidth) * 1024.0;
+}
+
+bool RequestScheduler::isEnabled() const
+{
+    return m_maxConnections > 0 || m_delay > 0 || m_bandwidth > 0;
+}
+
+void RequestScheduler::submit(ScheduledReply* reply)
+{
+    if (!m_hosts.contains(reply->host())) {
+        Host& host = m_hosts[reply->host()];
+        host.tokens = m_bandwidth;
+        host.refilled.start();
+    }
+    m_hosts[reply->host()].waiting[reply->priority()].enqueue(reply);
+    pump();
+}
+
+void RequestScheduler::cancel(ScheduledReply* reply)
+{
+    if (!m_hosts.contains(reply->host())) {
+        return;
+    }
+    QMap<int, QQueue<ScheduledReply*> >& waiting = m_hosts[reply->host()].waiting;
+    if (waiting.contains(reply->priority())) {
+        waiting[reply->priority()].removeAll(reply);
+    }
+}
+
+void RequestScheduler::release(ScheduledReply* reply)
+{
+    if (!m_hosts.contains(reply->host())) {
+        return;
+    }
+    Host& host = m_hosts[reply->host()];
+    if (host.active > 0) {
+        host.active--;
+    }
+    schedulePump(0);
+}
+
+void RequestScheduler::received(const QString& host, qint64 bytes)
+{
+    if (m_bandwidth <= 0 || !m_hosts.contains(host)) {
+        return;
+    }
+    Host& h = m_hosts[host];
+    refill(h);
+    h.tokens -= bytes;
+}
+
+// private slots:
+void RequestScheduler::pump()
+{
+    QList<ScheduledReply*> ready;
+    qint64 next = -1;
+
+    QMutableHashIterator<QString, Host> i(m_hosts);
+    while (i.hasNext()) {
+        i.next();
+        Host& host = i.value();
+
+        while (!host.waiting.isEmpty()) {
+            QMap<int, QQueue<ScheduledReply*> >::iterator queue = host.waiting.begin();
+            if (queue.value().isEmpty()) {
+                host.waiting.erase(queue);
+                continue;
+            }
+
+            qint64 wait = waitTime(host);
+            if (wait != 0) {
+                if (wait > 0 && (next < 0 || wait < next)) {
+                    next = wait;
+                }
+                break;
+            }
+
+            ready << queue.value().dequeue();
+            host.active++;
+            host.lastStart.start();
+        }
+
+        // forget hosts that no longer constrain anything
+        if (host.active == 0 && host.waiting.isEmpty()
+                && (m_delay == 0 || host.lastStart.elapsed() >= m_delay)
+                && (m_bandwidth <= 0 || (refill(host), host.tokens >= m_bandwidth))) {
+            i.remove();
+        }
+    }
+
+    if (next >= 0) {
+        schedulePump(next);
+    }
+
+    // start outside the loop, a reply may finish (and release) synchronously
+    foreach (ScheduledReply* reply, ready) {
+        reply->start();
+    }
+}
+
+// private:
+void RequestScheduler::refill(Host& host)
+{
+    if (m_bandwidth <= 0) {
+        return;
+    }
+    host.tokens = qMin(m_bandwidth, host.tokens + host.refilled.restart() * m_bandwidth / 1000.0);
+}
+
+// 0: may start now, -1: wait for a running request, else milliseconds
+qint64 RequestScheduler::waitTime(Host& host)
+{
+    if (m_maxConnections > 0 && host.active >= m_maxConnections) {
+        return -1;
+    }
+
+    qint64 wait = 0;
+    if (m_delay > 0 && host.lastStart.isValid()) {
+        wait = qMax(wait, m_delay - host.lastStart.elapsed());
+    }
+    if (m_bandwidth > 0) {
+        refill(host);
+        if (host.tokens < 0) {
+            wait = qMax(wait, qint64(-host.tokens * 1000 / m_bandwidth) + 1);
+        }
+    }
+    return wait;
+}
+
+void RequestScheduler::schedulePump(qint64 msec)
+{
+    if (m_timer->isActive() && m_timer->remainingTime() <= msec) {
+        return;
+    }
+    m_timer->start(int(msec));
+}
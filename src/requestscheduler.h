@@ -0,0 +1,69 @@
+#ifndef REQUESTSCHEDULER_H
+#define REQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QQueue>
+
+class QTimer;
+class ScheduledReply;
+
+/**
+ * Process wide per-host politeness for the network requests of every page.
+ *
+ * Requests to one host start only while
+ *  - fewer than '--max-host-connections' of them are running,
+ *  - at least '--host-delay' ms passed since the previous one started,
+ *  - the host's token bucket ('--host-bandwidth' KB/s, one second burst)
+ *    is not in debt for the bytes already received.
+ * Waiting requests start in priority order: documents, then other
+ * subresources, then images.
+ *
+ * Without any limit set the scheduler is disabled and
+ * NetworkAccessManager does not route requests through it.
+ */
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Priority { DocumentPriority = 0, SubresourcePriority, ImagePriority };
+
+    static RequestScheduler* instance();
+
+    void setLimits(int maxConnections, int delay, int bandwidth);
+    bool isEnabled() const;
+
+    void submit(ScheduledReply* reply);
+    void cancel(ScheduledReply* reply);
+    void release(ScheduledReply* reply);
+    void received(const QString& host, qint64 bytes);
+
+private slots:
+    void pump();
+
+private:
+    RequestScheduler(QObject* parent);
+
+    struct Host {
+        Host() : active(0), tokens(0) {}
+        int active;
+        QElapsedTimer lastStart;
+        double tokens;
+        QElapsedTimer refilled;
+        QMap<int, QQueue<ScheduledReply*> > waiting;
+    };
+
+    void refill(Host& host);
+    qint64 waitTime(Host& host);
+    void schedulePump(qint64 msec);
+
+    int m_maxConnections;
+    int m_delay;
+    double m_bandwidth;
+    QHash<QString, Host> m_hosts;
+    QTimer* m_timer;
+};
+
+#endif // REQUESTSCHEDULER_H
@@ -0,0 +1,113 @@
+#include "resourcefilter.h"
+
+#include <QNetworkRequest>
+#include <QUrl>
+
+// path extensions of each type
+static QHash<QString, QStringList> type_extensions()
+{
+    static QHash<QString, QStringList> extensions;
+    if (extensions.isEmpty()) {
+        extensions["font"] = QStringList() << "woff" << "woff2" << "ttf" << "otf" << "eot";
+        extensions["media"] = QStringList() << "mp4" << "m4v" << "webm" << "ogv" << "ogg" << "mp3" << "m4a" << "wav"
+                                            << "flac" << "aac" << "avi" << "mov" << "mkv" << "flv" << "swf" << "m3u8";
+        extensions["image"] = QStringList() << "png" << "jpg" << "jpeg" << "gif" << "webp" << "bmp" << "ico" << "svg" << "avif";
+        extensions["stylesheet"] = QStringList() << "css";
+        extensions["script"] = QStringList() << "js" << "mjs";
+    }
+    return extensions;
+}
+
+ResourceFilter::ResourceFilter()
+{
+}
+
+bool ResourceFilter::addType(const QString& rule)
+{
+    QString text = rule.trimmed().toLower();
+    if (text.startsWith('.') && text.length() > 1) {
+        m_extensions[text.mid(1)] = text;
+        return true;
+    }
+    if (!type_extensions().contains(text)) {
+        return false;
+    }
+    m_types.insert(text);
+    foreach (const QString& extension, type_extensions().value(text)) {
+        m_extensions[extension] = text;
+    }
+    return true;
+}
+
+void ResourceFilter::addUrlPattern(const QString& pattern)
+{
+    QString text = pattern.trimmed();
+    if (!text.isEmpty()) {
+        m_urls << QRegExp(text, Qt::CaseInsensitive, QRegExp::Wildcard);
+    }
+}
+
+bool ResourceFilter::isEmpty() const
+{
+    return m_extensions.isEmpty() && m_urls.isEmpty();
+}
+
+QString ResourceFilter::match(const QNetworkRequest& request) const
+{
+    QByteArray accept = request.rawHeader("Accept");
+    if (isEmpty() || accept.contains("text/html")) {
+        return QString();
+    }
+
+    if (!m_urls.isEmpty()) {
+        QString url = request.url().toString();
+        foreach (const QRegExp& wc, m_urls) {
+            if (wc.exactMatch(url)) {
+                return "url";
+            }
+        }
+    }
+
+    QString path = request.url().path();
+    int dot = path.lastIndexOf('.');
+    if (dot > path.lastIndexOf('/')) {
+        QString rule = m_extensions.value(path.mid(dot + 1).toLower());
+        if (!rule.isEmpty()) {
+            return rule;
+        }
+    }
+
+    // WebKit asks for stylesheets and images by Accept, scripts with */*
+    QString type = contentTypeOf(QString::fromLatin1(accept.split(',').first()));
+    return m_types.contains(type) ? type : QString();
+}
+
+QString ResourceFilter::matchContentType(const QString& contentType) const
+{
+    QString type = contentTypeOf(contentType);
+    return m_types.contains(type) ? type : QString();
+}
+
+// private:
+QString ResourceFilter::contentTypeOf(const QString& contentType)
+{
+    QString mime = contentType.section(';', 0, 0).trimmed().toLower();
+    if (mime.startsWith("font/") || mime.startsWith("application/font") || mime.startsWith("application/x-font")
+            || mime == "application/vnd.ms-fontobject") {
+        return "font";
+    }
+    if (mime.startsWith("video/") || mime.startsWith("audio/") || mime.endsWith("mpegurl")
+            || mime == "application/x-shockwave-flash") {
+        return "media";
+    }
+    if (mime.startsWith("image/")) {
+        return "image";
+    }
+    if (mime == "text/css") {
+        return "stylesheet";
+    }
+    if (mime.contains("javascript") || mime.contains("ecmascript")) {
+        return "script";
+    }
+    return QString();
+}
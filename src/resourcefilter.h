@@ -0,0 +1,55 @@
+#ifndef RESOURCEFILTER_H
+#define RESOURCEFILTER_H
+
+#include <QHash>
+#include <QList>
+#include <QRegExp>
+#include <QSet>
+#include <QString>
+
+class QNetworkRequest;
+
+/**
+ * Subresources NetworkAccessManager does not load, the '--block-resource'
+ * and '--block-url' rules.
+ *
+ * A request is refused when its URL matches a '--block-url' wildcard
+ * (trackers, ads), when the extension of its path belongs to a blocked
+ * type ("font", "media", "image", "stylesheet", "script") or is listed
+ * itself (".pdf"), or when its Accept header asks for a blocked type.
+ * A reply whose Content-Type turns out to be of a blocked type is aborted
+ * once its headers arrive. Documents (Accept: text/html) are never blocked.
+ */
+class ResourceFilter
+{
+public:
+    ResourceFilter();
+
+    /**
+     * @return false if `rule` is neither a known type nor an ".ext"
+     */
+    bool addType(const QString& rule);
+    void addUrlPattern(const QString& pattern);
+
+    bool isEmpty() const;
+
+    /**
+     * @return the rule blocking `request`: a type, an ".ext" or "url";
+     * empty if it is loaded
+     */
+    QString match(const QNetworkRequest& request) const;
+
+    /**
+     * @return the blocked type of a response `contentType`, empty if none
+     */
+    QString matchContentType(const QString& contentType) const;
+
+private:
+    static QString contentTypeOf(const QString& contentType);
+
+    QSet<QString> m_types;
+    QHash<QString, QString> m_extensions;
+    QList<QRegExp> m_urls;
+};
+
+#endif // RESOURCEFILTER_H
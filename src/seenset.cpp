@@ -0,0 +1,341 @@
+#include "seenset.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+
+#include <math.h>
+#include <string.h>
+
+// bloom filter file: header followed by the bit array
+//   0  char[8]  magic "BRDSEEN1"
+//   8  quint64  number of bits (little endian)
+//   16 quint32  number of hash functions
+//   20 quint32  reserved
+//   24 quint64  number of inserted keys
+static const char SEEN_FILE_MAGIC[8] = { 'B', 'R', 'D', 'S', 'E', 'E', 'N', '1' };
+static const int SEEN_FILE_HEADER = 32;
+
+static const int SEEN_TABLE_MIN = 1024;
+
+// Qt < 5.8
+#ifndef Q_FALLTHROUGH
+#define Q_FALLTHROUGH() (void)0
+#endif
+
+// checkpoint file: magic "BRDSEENT", quint64 count, count * quint64 hash
+static const char SEEN_TABLE_MAGIC[8] = { 'B', 'R', 'D', 'S', 'E', 'E', 'N', 'T' };
+
+SeenSet::SeenSet()
+    : m_size(0)
+    , m_file(0)
+    , m_map(0)
+    , m_bits(0)
+    , m_hashes(0)
+{
+}
+
+SeenSet::~SeenSet()
+{
+    if (m_file) {
+        if (m_map) {
+            m_file->unmap(m_map);
+        }
+        m_file->close();
+        delete m_file;
+    }
+}
+
+// MurmurHash64A (Austin Appleby, public domain), blocks read as little
+// endian so bloom filter files are portable between hosts
+quint64 SeenSet::hash(const QByteArray& data, quint64 seed)
+{
+    const quint64 m = Q_UINT64_C(0xc6a4a7935bd1e995);
+    const int r = 47;
+    const int len = data.size();
+    const uchar* p = reinterpret_cast<const uchar*>(data.constData());
+
+    quint64 h = seed ^ (quint64(len) * m);
+
+    const int blocks = len / 8;
+    for (int i = 0; i < blocks; ++i) {
+        quint64 k = qFromLittleEndian<quint64>(p + i * 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    const uchar* tail = p + blocks * 8;
+    switch (len & 7) {
+    case 7: h ^= quint64(tail[6]) << 48; Q_FALLTHROUGH();
+    case 6: h ^= quint64(tail[5]) << 40; Q_FALLTHROUGH();
+    case 5: h ^= quint64(tail[4]) << 32; Q_FALLTHROUGH();
+    case 4: h ^= quint64(tail[3]) << 24; Q_FALLTHROUGH();
+    case 3: h ^= quint64(tail[2]) << 16; Q_FALLTHROUGH();
+    case 2: h ^= quint64(tail[1]) << 8; Q_FALLTHROUGH();
+    case 1: h ^= quint64(tail[0]);
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+bool SeenSet::attach(const QString& filePath, qint64 capacity, QString* error)
+{
+    QFile* file = new QFile(filePath);
+    if (!file->open(QIODevice::ReadWrite)) {
+        if (error) {
+            *error = file->errorString();
+        }
+        delete file;
+        return false;
+    }
+
+    quint64 bits = 0;
+    int hashes = 0;
+    if (file->size() >= SEEN_FILE_HEADER) {
+        QByteArray header = file->read(SEEN_FILE_HEADER);
+        const uchar* p = reinterpret_cast<const uchar*>(header.constData());
+        bits = qFromLittleEndian<quint64>(p + 8);
+        hashes = qFromLittleEndian<quint32>(p + 16);
+        if (memcmp(p, SEEN_FILE_MAGIC, 8) != 0 || bits == 0 || hashes == 0
+                || file->size() != SEEN_FILE_HEADER + qint64((bits + 7) / 8)) {
+            if (error) {
+                *error = "not a seen-set file";
+            }
+            delete file;
+            return false;
+        }
+    } else {
+        // 1% false positives: m = -n ln(p) / ln(2)^2, k = m / n ln(2)
+        if (capacity < 1) {
+            capacity = 1;
+        }
+        bits = quint64(ceil(-double(capacity) * log(0.01) / (log(2.0) * log(2.0))));
+        bits = (bits + 63) & ~Q_UINT64_C(63);
+        hashes = 7;
+
+        uchar header[SEEN_FILE_HEADER];
+        memset(header, 0, sizeof(header));
+        memcpy(header, SEEN_FILE_MAGIC, 8);
+        qToLittleEndian<quint64>(bits, header + 8);
+        qToLittleEndian<quint32>(hashes, header + 16);
+        file->resize(0);
+        file->write(reinterpret_cast<const char*>(header), sizeof(header));
+        if (!file->resize(SEEN_FILE_HEADER + qint64(bits / 8))) {
+            if (error) {
+                *error = file->errorString();
+            }
+            delete file;
+            return false;
+        }
+    }
+
+    uchar* map = file->map(0, file->size());
+    if (!map) {
+        if (error) {
+            *error = file->errorString();
+        }
+        delete file;
+        return false;
+    }
+
+    if (m_file) {
+        m_file->unmap(m_map);
+        delete m_file;
+    }
+    m_file = file;
+    m_map = map;
+    m_bits = bits;
+    m_hashes = hashes;
+    qDebug() << "SeenSet - attached" << filePath << ":" << m_bits << "bits," << m_hashes << "hashes,"
+             << qFromLittleEndian<quint64>(m_map + 24) << "keys";
+    return true;
+}
+
+bool SeenSet::isAttached() const
+{
+    return m_map != 0;
+}
+
+bool SeenSet::insert(const QByteArray& key, bool checkFile)
+{
+    quint64 h = hash(key);
+    if (!tableInsert(h)) {
+        return false;
+    }
+    if (m_map) {
+        if (bloomContains(h)) {
+            return !checkFile;
+        }
+        m_unflushed.append(h);
+    }
+    return true;
+}
+
+bool SeenSet::contains(const QByteArray& key) const
+{
+    quint64 h = hash(key);
+    return tableContains(h) || (m_map && bloomContains(h));
+}
+
+void SeenSet::flush()
+{
+    if (m_map) {
+        foreach (quint64 h, m_unflushed) {
+            bloomInsert(h);
+        }
+    }
+    m_unflushed.clear();
+}
+
+int SeenSet::size() const
+{
+    return m_size;
+}
+
+void SeenSet::clear()
+{
+    m_slots.clear();
+    m_size = 0;
+}
+
+bool SeenSet::save(const QString& filePath) const
+{
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    uchar value[8];
+    file.write(SEEN_TABLE_MAGIC, 8);
+    qToLittleEndian<quint64>(m_size, value);
+    file.write(reinterpret_cast<const char*>(value), 8);
+    foreach (quint64 h, m_slots) {
+        if (h != 0) {
+            qToLittleEndian<quint64>(h, value);
+            file.write(reinterpret_cast<const char*>(value), 8);
+        }
+    }
+    return file.commit();
+}
+
+bool SeenSet::load(const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QByteArray data = file.readAll();
+    const uchar* p = reinterpret_cast<const uchar*>(data.constData());
+    if (data.size() < 16 || memcmp(p, SEEN_TABLE_MAGIC, 8) != 0) {
+        return false;
+    }
+    quint64 count = qFromLittleEndian<quint64>(p + 8);
+    if (quint64(data.size()) != 16 + count * 8) {
+        return false;
+    }
+    for (quint64 i = 0; i < count; ++i) {
+        tableInsert(qFromLittleEndian<quint64>(p + 16 + i * 8));
+    }
+    return true;
+}
+
+// private:
+// linear probing, 0 marks an empty slot
+bool SeenSet::tableInsert(quint64 h)
+{
+    if (h == 0) {
+        h = 1;
+    }
+    if ((m_size + 1) * 2 > m_slots.size()) {
+        grow();
+    }
+
+    int mask = m_slots.size() - 1;
+    quint64* slots = m_slots.data();
+    for (int i = int(h) & mask; ; i = (i + 1) & mask) {
+        if (slots[i] == h) {
+            return false;
+        }
+        if (slots[i] == 0) {
+            slots[i] = h;
+            m_size++;
+            return true;
+        }
+    }
+}
+
+bool SeenSet::tableContains(quint64 h) const
+{
+    if (h == 0) {
+        h = 1;
+    }
+    if (m_slots.isEmpty()) {
+        return false;
+    }
+
+    int mask = m_slots.size() - 1;
+    const quint64* slots = m_slots.constData();
+    for (int i = int(h) & mask; ; i = (i + 1) & mask) {
+        if (slots[i] == h) {
+            return true;
+        }
+        if (slots[i] == 0) {
+            return false;
+        }
+    }
+}
+
+void SeenSet::grow()
+{
+    QVector<quint64> old = m_slots;
+    m_slots = QVector<quint64>(qMax(SEEN_TABLE_MIN, old.size() * 2), 0);
+    m_size = 0;
+
+    int mask = m_slots.size() - 1;
+    quint64* slots = m_slots.data();
+    foreach (quint64 h, old) {
+        if (h == 0) {
+            continue;
+        }
+        int i = int(h) & mask;
+        while (slots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = h;
+        m_size++;
+    }
+}
+
+// double hashing (Kirsch-Mitzenmacher) over the one 64-bit hash
+bool SeenSet::bloomContains(quint64 h) const
+{
+    const uchar* bits = m_map + SEEN_FILE_HEADER;
+    quint64 h2 = (h >> 33 | h << 31) | 1;
+    for (int i = 0; i < m_hashes; ++i) {
+        quint64 bit = (h + quint64(i) * h2) % m_bits;
+        if (!(bits[bit >> 3] & (1 << (bit & 7)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SeenSet::bloomInsert(quint64 h)
+{
+    uchar* bits = m_map + SEEN_FILE_HEADER;
+    quint64 h2 = (h >> 33 | h << 31) | 1;
+    for (int i = 0; i < m_hashes; ++i) {
+        quint64 bit = (h + quint64(i) * h2) % m_bits;
+        bits[bit >> 3] |= uchar(1 << (bit & 7));
+    }
+    qToLittleEndian<quint64>(qFromLittleEndian<quint64>(m_map + 24) + 1, m_map + 24);
+}
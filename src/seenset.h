@@ -0,0 +1,88 @@
+#ifndef SEENSET_H
+#define SEENSET_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+class QFile;
+
+/**
+ * Set of "already seen" keys (URLs) that keeps only a 64-bit hash per key.
+ *
+ * Keys are hashed with a non-cryptographic 64-bit hash and stored in an
+ * open addressing table of 8 byte slots, instead of one hex digest string
+ * per key.
+ *
+ * attach() adds a memory-mapped bloom filter file that outlives the
+ * process: keys inserted in an earlier run are reported as seen. A bloom
+ * filter has false positives, sized by attach() for about 1% at the given
+ * capacity; a false positive skips a key that was never seen.
+ *
+ * New keys reach the bloom filter file on flush() only, once the crawl
+ * state that saw them is saved: links queued after the last checkpoint
+ * must not be skipped by the run that resumes it.
+ */
+class SeenSet
+{
+public:
+    SeenSet();
+    ~SeenSet();
+
+    static quint64 hash(const QByteArray& data, quint64 seed = 0);
+
+    /**
+     * Open (or create) the bloom filter file at `filePath`. An existing file
+     * keeps its own size, `capacity` is the expected number of keys of a new one.
+     */
+    bool attach(const QString& filePath, qint64 capacity, QString* error = 0);
+    bool isAttached() const;
+
+    /**
+     * @param checkFile when false the bloom filter is only updated, not
+     * consulted (seeds of a recrawl must be loaded again)
+     * @return true if `key` was not seen before
+     */
+    bool insert(const QByteArray& key, bool checkFile = true);
+    bool contains(const QByteArray& key) const;
+
+    /**
+     * Write the keys inserted since the last flush() to the bloom filter.
+     */
+    void flush();
+
+    int size() const;
+
+    /**
+     * Forget the keys of this process, the bloom filter file is kept.
+     */
+    void clear();
+
+    /**
+     * Write / read the in-memory hashes (checkpoints). load() adds to the
+     * current keys.
+     */
+    bool save(const QString& filePath) const;
+    bool load(const QString& filePath);
+
+private:
+    Q_DISABLE_COPY(SeenSet)
+
+    bool tableInsert(quint64 h);
+    bool tableContains(quint64 h) const;
+    void grow();
+
+    bool bloomContains(quint64 h) const;
+    void bloomInsert(quint64 h);
+
+    QVector<quint64> m_slots;
+    int m_size;
+    QVector<quint64> m_unflushed;
+
+    QFile* m_file;
+    uchar* m_map;
+    quint64 m_bits;
+    int m_hashes;
+};
+
+#endif // SEENSET_H
@@ -0,0 +1,416 @@
+#include "supervisor.h"
+
+#include <QDebug>
+#include <QDomDocument>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVariantMap>
+
+#include "config.h"
+#include "terminal.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+Supervisor::Supervisor(Config* config)
+    : m_config(config)
+    , m_isWorker(false)
+    , m_exhausted(false)
+    , m_jobsPerWorker(config->concurrency())
+{
+}
+
+Supervisor::~Supervisor()
+{
+    for (int i = 0; i < m_workers.size(); ++i) {
+        closeAll(m_workers[i]);
+    }
+}
+
+bool Supervisor::isWorker() const
+{
+    return m_isWorker;
+}
+
+int Supervisor::run()
+{
+    QString fileName = m_config->urlList();
+    bool opened = false;
+    if (fileName == "-") {
+        // read through a private descriptor, the FILE* buffer of stdin
+        // would otherwise be inherited by every worker
+        opened = m_input.open(dup(STDIN_FILENO), QIODevice::ReadOnly | QIODevice::Text, QFileDevice::AutoCloseHandle);
+    } else {
+        m_input.setFileName(fileName);
+        opened = m_input.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!opened) {
+        Terminal::instance()->cerr(QString("Open File[%1] error: %2").arg(fileName, m_input.errorString()));
+        return 1;
+    }
+    m_urls.setDevice(&m_input);
+    m_urls.setCodec("utf-8");
+
+    if (!m_config->outputFile().isEmpty()) {
+        m_output.setFileName(m_config->outputFile());
+        if (!m_output.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            Terminal::instance()->cerr(QString("Open File[%1] error: %2").arg(m_output.fileName(), m_output.errorString()));
+            return 1;
+        }
+    }
+
+    // a worker dying between poll() and write() must not kill us
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int i = 0; i < m_config->workers(); ++i) {
+        Worker worker;
+        worker.pid = -1;
+        worker.in = -1;
+        worker.out = -1;
+        worker.timedOut = false;
+        m_workers.append(worker);
+        if (!spawn(m_workers[i])) {
+            return m_isWorker ? 0 : 1;
+        }
+    }
+
+    forever {
+        bool running = false;
+        QList<struct pollfd> fds;
+        for (int i = 0; i < m_workers.size(); ++i) {
+            Worker& worker = m_workers[i];
+            if (worker.pid <= 0 && !m_exhausted) {
+                if (!spawn(worker)) {
+                    return m_isWorker ? 0 : 1;
+                }
+            }
+            if (worker.pid <= 0) {
+                continue;
+            }
+            running = true;
+            feed(worker);
+            if (worker.out >= 0) {
+                struct pollfd pfd;
+                pfd.fd = worker.out;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+                fds.append(pfd);
+            }
+        }
+        if (!running) {
+            break;
+        }
+
+        if (poll(fds.isEmpty() ? NULL : &fds[0], fds.size(), 1000) < 0 && errno != EINTR) {
+            qWarning() << "Supervisor - poll failed:" << strerror(errno);
+        }
+
+        for (int i = 0; i < fds.size(); ++i) {
+            if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            for (int j = 0; j < m_workers.size(); ++j) {
+                if (m_workers[j].out == fds[i].fd) {
+                    readRecords(m_workers[j], false);
+                }
+            }
+        }
+
+        killHungWorkers();
+        reap();
+    }
+
+    return 0;
+}
+
+// private:
+bool Supervisor::spawn(Worker& worker)
+{
+    int toWorker[2];
+    int fromWorker[2];
+    if (pipe(toWorker) != 0) {
+        return false;
+    }
+    if (pipe(fromWorker) != 0) {
+        ::close(toWorker[0]);
+        ::close(toWorker[1]);
+        return false;
+    }
+
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        qWarning() << "Supervisor - fork failed:" << strerror(errno);
+        return false;
+    }
+
+    if (pid == 0) {
+        // worker: URLs on stdin, records on stdout
+        dup2(toWorker[0], STDIN_FILENO);
+        dup2(fromWorker[1], STDOUT_FILENO);
+        ::close(toWorker[0]);
+        ::close(toWorker[1]);
+        ::close(fromWorker[0]);
+        ::close(fromWorker[1]);
+        for (int i = 0; i < m_workers.size(); ++i) {
+            if (m_workers[i].in >= 0) {
+                ::close(m_workers[i].in);
+            }
+            if (m_workers[i].out >= 0) {
+                ::close(m_workers[i].out);
+            }
+            m_workers[i].in = m_workers[i].out = m_workers[i].pid = -1;
+        }
+        m_input.close();
+        m_output.close();
+        signal(SIGPIPE, SIG_DFL);
+
+        m_isWorker = true;
+        return false;
+    }
+
+    ::close(toWorker[0]);
+    ::close(fromWorker[1]);
+    worker.pid = pid;
+    worker.in = toWorker[1];
+    worker.out = fromWorker[0];
+    worker.buffer.clear();
+    worker.jobs.clear();
+    worker.timedOut = false;
+    qDebug() << "Supervisor - worker started:" << pid;
+    return true;
+}
+
+bool Supervisor::feed(Worker& worker)
+{
+    while (worker.in >= 0 && worker.jobs.size() < m_jobsPerWorker) {
+        QString url = readNextUrl();
+        if (url.isEmpty()) {
+            m_exhausted = true;
+            break;
+        }
+
+        QByteArray line = url.toUtf8() + '\n';
+        if (::write(worker.in, line.constData(), line.size()) != line.size()) {
+            // the worker is gone, reap() reports the job
+            Job job;
+            job.url = url;
+            job.started.start();
+            worker.jobs.append(job);
+            closeInput(worker);
+            return false;
+        }
+
+        Job job;
+        job.url = url;
+        job.started.start();
+        worker.jobs.append(job);
+    }
+
+    // no more URLs: let the worker drain and exit
+    if (m_exhausted) {
+        closeInput(worker);
+    }
+    return true;
+}
+
+void Supervisor::readRecords(Worker& worker, bool eof)
+{
+    char buf[65536];
+    forever {
+        ssize_t n = ::read(worker.out, buf, sizeof(buf));
+        if (n > 0) {
+            worker.buffer.append(buf, n);
+            if (!eof) {
+                break;
+            }
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        break;
+    }
+
+    int pos;
+    while ((pos = worker.buffer.indexOf('\n')) >= 0) {
+        QByteArray record = worker.buffer.left(pos);
+        worker.buffer.remove(0, pos + 1);
+        if (record.trimmed().isEmpty()) {
+            continue;
+        }
+        writeRecord(record);
+
+        // attribute the record to its job, oldest job if the url is unknown
+        QString url = recordUrl(record);
+        int index = 0;
+        for (int i = 0; i < worker.jobs.size(); ++i) {
+            if (worker.jobs[i].url == url) {
+                index = i;
+                break;
+            }
+        }
+        if (!worker.jobs.isEmpty()) {
+            worker.jobs.removeAt(index);
+        }
+    }
+}
+
+void Supervisor::reap()
+{
+    int status = 0;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        for (int i = 0; i < m_workers.size(); ++i) {
+            Worker& worker = m_workers[i];
+            if (worker.pid != pid) {
+                continue;
+            }
+
+            // collect whatever the worker wrote before it went away
+            if (worker.out >= 0) {
+                readRecords(worker, true);
+            }
+
+            if (worker.timedOut) {
+                failJobs(worker, "worker_timeout", status);
+            } else if (WIFSIGNALED(status)) {
+                qWarning() << "Supervisor - worker" << pid << "killed by signal" << WTERMSIG(status);
+                failJobs(worker, "worker_crashed", status);
+            } else if (!worker.jobs.isEmpty()) {
+                failJobs(worker, "worker_exited", status);
+            }
+
+            closeAll(worker);
+            worker.pid = -1;
+        }
+    }
+}
+
+void Supervisor::killHungWorkers()
+{
+    qint64 timeout = qint64(m_config->workerTimeout()) * 1000;
+    if (timeout <= 0) {
+        return;
+    }
+
+    for (int i = 0; i < m_workers.size(); ++i) {
+        Worker& worker = m_workers[i];
+        if (worker.pid <= 0 || worker.timedOut || worker.jobs.isEmpty()) {
+            continue;
+        }
+        if (worker.jobs.first().started.elapsed() > timeout) {
+            qWarning() << "Supervisor - worker" << worker.pid << "hung on" << worker.jobs.first().url;
+            worker.timedOut = true;
+            kill(worker.pid, SIGKILL);
+        }
+    }
+}
+
+void Supervisor::failJobs(Worker& worker, const QString& error, int status)
+{
+    foreach (const Job& job, worker.jobs) {
+        QVariantMap record;
+        record["url"] = job.url;
+        record["error"] = error;
+        record["time_cost"] = job.started.elapsed();
+        if (WIFSIGNALED(status)) {
+            record["signal"] = WTERMSIG(status);
+        } else if (WIFEXITED(status)) {
+            record["exit_code"] = WEXITSTATUS(status);
+        }
+        writeRecord(serialize(record));
+    }
+    worker.jobs.clear();
+}
+
+void Supervisor::closeInput(Worker& worker)
+{
+    if (worker.in >= 0) {
+        ::close(worker.in);
+        worker.in = -1;
+    }
+}
+
+void Supervisor::closeAll(Worker& worker)
+{
+    closeInput(worker);
+    if (worker.out >= 0) {
+        ::close(worker.out);
+        worker.out = -1;
+    }
+}
+
+QString Supervisor::recordUrl(const QByteArray& record) const
+{
+    if (m_config->outputFormat() == "json") {
+        return QJsonDocument::fromJson(record).object().value("url").toString();
+    }
+
+    QDomDocument doc;
+    if (!doc.setContent(record)) {
+        return QString();
+    }
+    QDomElement node = doc.documentElement().firstChildElement("element");
+    for (; !node.isNull(); node = node.nextSiblingElement("element")) {
+        if (node.attribute("name") == "url") {
+            return node.attribute("value");
+        }
+    }
+    return QString();
+}
+
+QByteArray Supervisor::serialize(const QVariantMap& record) const
+{
+    if (m_config->outputFormat() == "json") {
+        return QJsonDocument(QJsonObject::fromVariantMap(record)).toJson(QJsonDocument::Compact);
+    }
+
+    // same layout as the worker's json2xml() for a flat record
+    QDomDocument doc;
+    doc.appendChild(doc.createProcessingInstruction("xml", "version=\"1.0\" encoding=\"UTF-8\""));
+    QDomElement root = doc.createElement("bradypod");
+    doc.appendChild(root);
+    QMapIterator<QString, QVariant> i(record);
+    while (i.hasNext()) {
+        i.next();
+        QDomElement node = doc.createElement("element");
+        node.setAttribute("name", i.key());
+        node.setAttribute("value", i.value().toString());
+        root.appendChild(node);
+    }
+    return doc.toByteArray(-1);
+}
+
+QString Supervisor::readNextUrl()
+{
+    while (!m_urls.atEnd()) {
+        QString line = m_urls.readLine().trimmed();
+        // skip blank lines and comments
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        return line;
+    }
+    return QString();
+}
+
+void Supervisor::writeRecord(const QByteArray& record)
+{
+    if (m_output.isOpen()) {
+        m_output.write(record);
+        m_output.write("\n");
+        m_output.flush();
+    } else {
+        fwrite(record.constData(), 1, record.size(), stdout);
+        fputc('\n', stdout);
+        fflush(stdout);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QTextStream>
+#include <QVariantMap>
+
+class Config;
+
+/**
+ * Pre-forked worker supervisor ('--workers N', unix only).
+ *
+ * main() warms up QApplication, fonts, CA certificates and the WebKit
+ * settings once and then hands over to run(), which forks the workers.
+ * A worker inherits the warmed up process and continues as a normal
+ * '--url-list=-' batch process: it reads URLs from its stdin pipe and
+ * writes one record per line to its stdout pipe.
+ *
+ * The supervisor feeds URLs, collects records into the output, and
+ * restarts workers that crash or exceed '--worker-timeout' on a job.
+ * Jobs of a lost worker are reported with an "error" record.
+ */
+class Supervisor
+{
+public:
+    explicit Supervisor(Config* config);
+    ~Supervisor();
+
+    /**
+     * Returns twice: in a forked worker with isWorker() set, or in the
+     * supervisor once every URL is done.
+     * @return exit code for the supervisor process
+     */
+    int run();
+    bool isWorker() const;
+
+private:
+    struct Job {
+        QString url;
+        QElapsedTimer started;
+    };
+
+    struct Worker {
+        int pid;
+        int in;             // URLs to the worker
+        int out;            // records from the worker
+        QByteArray buffer;
+        QList<Job> jobs;
+        bool timedOut;
+    };
+
+    bool spawn(Worker& worker);
+    bool feed(Worker& worker);
+    void readRecords(Worker& worker, bool eof);
+    void reap();
+    void killHungWorkers();
+    void failJobs(Worker& worker, const QString& error, int status);
+    void closeInput(Worker& worker);
+    void closeAll(Worker& worker);
+
+    QString recordUrl(const QByteArray& record) const;
+    QByteArray serialize(const QVariantMap& record) const;
+    QString readNextUrl();
+    void writeRecord(const QByteArray& record);
+
+    Config* m_config;
+    bool m_isWorker;
+    bool m_exhausted;
+    int m_jobsPerWorker;
+    QList<Worker> m_workers;
+    QFile m_input;
+    QTextStream m_urls;
+    QFile m_output;
+};
+
+#endif // SUPERVISOR_H
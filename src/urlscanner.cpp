@@ -0,0 +1,295 @@
+#include "urlscanner.h"
+
+#include <QtAlgorithms>
+#include <string.h>
+
+// qCpuHasFeature(), QT_FUNCTION_TARGET()
+#include <private/qsimd_p.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(QT_COMPILER_SUPPORTS_AVX2)
+#include <immintrin.h>
+#endif
+
+static const int SCAN_MIN_PATH = 2;
+
+// a token ends at a control byte, space or one of these
+static inline bool is_token_end(uchar c)
+{
+    switch (c) {
+    case '"': case '\'': case '`': case '<': case '>': case '(': case ')': case '{': case '}': case '|': case '\\':
+        return true;
+    default:
+        return c <= ' ';
+    }
+}
+
+static inline bool is_alpha(uchar c)
+{
+    return (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+}
+
+static inline bool is_path_byte(uchar c)
+{
+    return is_alpha(c) || (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.' || c == '~' || c >= 0x80;
+}
+
+static inline bool is_scheme_byte(uchar c)
+{
+    return is_alpha(c) || (c >= '0' && c <= '9') || c == '+' || c == '-' || c == '.';
+}
+
+static inline bool is_open(uchar c)
+{
+    return c == '"' || c == '\'' || c == '`' || c == '(' || c == '=';
+}
+
+// slash search: bit i of the mask is set when p[i] == '/', over a 64 byte block
+
+static const int SCAN_BLOCK = 64;
+
+static quint64 slashes_scalar(const char* p, int length)
+{
+    quint64 mask = 0;
+    for (int i = 0; i < length; ++i) {
+        if (p[i] == '/') {
+            mask |= Q_UINT64_C(1) << i;
+        }
+    }
+    return mask;
+}
+
+#if defined(__SSE2__)
+static quint64 slashes_sse2(const char* p)
+{
+    const __m128i slash = _mm_set1_epi8('/');
+    quint64 mask = 0;
+    for (int i = 0; i < SCAN_BLOCK; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        mask |= quint64(uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, slash)))) << i;
+    }
+    return mask;
+}
+#endif
+
+#if defined(QT_COMPILER_SUPPORTS_AVX2)
+QT_FUNCTION_TARGET(AVX2)
+static quint64 slashes_avx2(const char* p)
+{
+    const __m256i slash = _mm256_set1_epi8('/');
+    __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+    return quint64(uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, slash))))
+            | quint64(uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, slash)))) << 32;
+}
+#endif
+
+static quint64 slashes_block(const char* p)
+{
+    return slashes_scalar(p, SCAN_BLOCK);
+}
+
+// token end search, same bytes as is_token_end()
+
+static const char* find_end_scalar(const char* p, const char* end)
+{
+    while (p < end && !is_token_end(uchar(*p))) {
+        ++p;
+    }
+    return p;
+}
+
+#if defined(__SSE2__)
+static const char* find_end_sse2(const char* p, const char* end)
+{
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; end - p >= 16; p += 16) {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        // unsigned c <= ' '
+        __m128i hit = _mm_cmpeq_epi8(_mm_min_epu8(c, space), c);
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('"')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('\'')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('`')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('<')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('>')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('(')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8(')')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('{')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('}')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('|')));
+        hit = _mm_or_si128(hit, _mm_cmpeq_epi8(c, _mm_set1_epi8('\\')));
+        uint mask = _mm_movemask_epi8(hit);
+        if (mask) {
+            return p + qCountTrailingZeroBits(mask);
+        }
+    }
+    return find_end_scalar(p, end);
+}
+#endif
+
+#if defined(QT_COMPILER_SUPPORTS_AVX2)
+QT_FUNCTION_TARGET(AVX2)
+static const char* find_end_avx2(const char* p, const char* end)
+{
+    const __m256i space = _mm256_set1_epi8(' ');
+    for (; end - p >= 32; p += 32) {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hit = _mm256_cmpeq_epi8(_mm256_min_epu8(c, space), c);
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('"')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\'')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('`')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('<')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('>')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('(')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(')')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('{')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('}')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('|')));
+        hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(c, _mm256_set1_epi8('\\')));
+        uint mask = _mm256_movemask_epi8(hit);
+        if (mask) {
+            return p + qCountTrailingZeroBits(mask);
+        }
+    }
+    return find_end_scalar(p, end);
+}
+#endif
+
+typedef quint64 (*MaskFunction)(const char* p);
+typedef const char* (*FindFunction)(const char* p, const char* end);
+
+struct ScanFunctions {
+    const char* isa;
+    MaskFunction slashes;
+    FindFunction end;
+};
+
+// the best instruction set of this CPU, or `wanted` when it is available
+static bool scan_functions(const char* wanted, ScanFunctions* functions)
+{
+#if defined(QT_COMPILER_SUPPORTS_AVX2)
+    if (qCpuHasFeature(AVX2) && (!wanted || strcmp(wanted, "avx2") == 0)) {
+        ScanFunctions avx2 = { "avx2", slashes_avx2, find_end_avx2 };
+        *functions = avx2;
+        return true;
+    }
+#endif
+#if defined(__SSE2__)
+    if (!wanted || strcmp(wanted, "sse2") == 0) {
+        ScanFunctions sse2 = { "sse2", slashes_sse2, find_end_sse2 };
+        *functions = sse2;
+        return true;
+    }
+#endif
+    if (!wanted || strcmp(wanted, "scalar") == 0) {
+        ScanFunctions scalar = { "scalar", slashes_block, find_end_scalar };
+        *functions = scalar;
+        return true;
+    }
+    return false;
+}
+
+static ScanFunctions best_functions()
+{
+    ScanFunctions functions;
+    scan_functions(0, &functions);
+    return functions;
+}
+
+static ScanFunctions scanner = best_functions();
+
+// Start of the token containing the slash at `slash`, 0 if there is none.
+// `skip` is where the next slash may be, a "//" is not looked at twice.
+static const char* token_start(const char* begin, const char* end, const char* slash, const char** skip)
+{
+    static const char* schemes[] = { "http", "https", "ws", "wss", "ftp" };
+
+    uchar before = slash > begin ? uchar(slash[-1]) : 0;
+    uchar after = slash + 1 < end ? uchar(slash[1]) : 0;
+    bool host = slash + 2 < end && is_path_byte(uchar(slash[2]));
+    *skip = slash + 1;
+
+    if (after == '/' && before == ':') {
+        // scheme://
+        const char* s = slash - 1;
+        while (s > begin && is_scheme_byte(uchar(s[-1]))) {
+            --s;
+        }
+        int length = int(slash - 1 - s);
+        for (uint i = 0; host && i < sizeof(schemes) / sizeof(schemes[0]); ++i) {
+            if (length == int(strlen(schemes[i])) && qstrnicmp(s, schemes[i], length) == 0) {
+                return s;
+            }
+        }
+    } else if (after == '/') {
+        // //host, "//" elsewhere is a comment or an empty path
+        if (is_open(before) && host) {
+            return slash;
+        }
+        *skip = slash + 2;
+    } else if (is_path_byte(after)) {
+        // /path ./path ../path
+        const char* s = slash;
+        while (s > begin && slash - s < 2 && s[-1] == '.') {
+            --s;
+        }
+        // srcset: "a.jpg 1x, /b.jpg 2x"
+        if (s > begin && (is_open(uchar(s[-1])) || (s - begin >= 2 && s[-1] == ' ' && s[-2] == ','))) {
+            return s;
+        }
+    }
+    return 0;
+}
+
+QList<QByteArray> UrlScanner::scan(const QByteArray& text, int max)
+{
+    QList<QByteArray> tokens;
+    const char* begin = text.constData();
+    const char* end = begin + text.size();
+    const char* p = begin;
+
+    // slashes are found a block at a time, then visited bit by bit
+    for (const char* block = begin; block < end; block += SCAN_BLOCK) {
+        if (p >= block + SCAN_BLOCK) {
+            continue;
+        }
+        quint64 mask = end - block >= SCAN_BLOCK ? scanner.slashes(block)
+                                                 : slashes_scalar(block, int(end - block));
+        while (mask) {
+            const char* slash = block + qCountTrailingZeroBits(mask);
+            mask &= mask - 1;
+            if (slash < p) {
+                continue;
+            }
+            const char* start = token_start(begin, end, slash, &p);
+            if (!start) {
+                continue;
+            }
+
+            const char* stop = scanner.end(slash + 1, end);
+            while (stop > slash + 1 && strchr(".,;:", stop[-1])) {
+                --stop;
+            }
+            if (stop - start >= SCAN_MIN_PATH) {
+                tokens << QByteArray(start, int(stop - start));
+                if (max > 0 && tokens.size() >= max) {
+                    return tokens;
+                }
+            }
+            p = stop;
+        }
+    }
+    return tokens;
+}
+
+QByteArray UrlScanner::isa()
+{
+    return scanner.isa;
+}
+
+bool UrlScanner::setIsa(const QByteArray& isa)
+{
+    return scan_functions(isa.constData(), &scanner);
+}
@@ -0,0 +1,46 @@
+#ifndef URLSCANNER_H
+#define URLSCANNER_H
+
+#include <QByteArray>
+#include <QList>
+
+/**
+ * Finds URL-like and path-like tokens in text: inline scripts and styles,
+ * srcset values, JSON/JS/CSS response bodies.
+ *
+ * Every token contains a '/', so the scan jumps from slash to slash and
+ * checks the few bytes around each one:
+ *   scheme://...     http, https, ws, wss and ftp URLs
+ *   "//host/..."     protocol relative, after a quote, '(' or '='
+ *   "/path", "./path", "../path"
+ *                    after a quote, '(', '=' or ", " (srcset) and followed
+ *                    by a path byte
+ * A token ends at a control byte, space, quote, backslash or one of <>(){}|.
+ * Trailing '.', ',', ';' and ':' are dropped.
+ *
+ * Searching the slashes and the token ends is what costs on large
+ * buffers: both run 32 (AVX2) or 16 (SSE2) bytes at a time, the
+ * instruction set chosen at runtime, and on plain loops elsewhere.
+ */
+class UrlScanner
+{
+public:
+    /**
+     * @param max stop after `max` tokens, 0 means no limit
+     * @return tokens in text order, repeated ones included
+     */
+    static QList<QByteArray> scan(const QByteArray& text, int max = 0);
+
+    /**
+     * Instruction set used by scan(): "avx2", "sse2" or "scalar".
+     */
+    static QByteArray isa();
+
+    /**
+     * Use `isa` instead of the best one (benchmarks, tests).
+     * @return false when this build or CPU can not run it
+     */
+    static bool setIsa(const QByteArray& isa);
+};
+
+#endif // URLSCANNER_H
@@ -8,6 +8,12 @@
 #include <QDir>
 #include <QWebFrame>
 
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#elif defined(Q_OS_MAC)
+#include <mach/mach.h>
+#endif
+
 static QString findScript(const QString& jsFilePath, const QString& libraryPath)
 {
     if (!jsFilePath.isEmpty()) {
@@ -136,4 +142,29 @@ QString readResourceFileUtf8(const QString& resourceFilePath)
     return QString::fromUtf8(f.readAll());
 }
 
+qint64 residentMemory()
+{
+#if defined(Q_OS_LINUX)
+    // statm: size resident shared ... (in pages)
+    QFile f("/proc/self/statm");
+    if (!f.open(QFile::ReadOnly)) {
+        return -1;
+    }
+    QList<QByteArray> fields = f.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#elif defined(Q_OS_MAC)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS) {
+        return -1;
+    }
+    return info.resident_size;
+#else
+    return -1;
+#endif
+}
+
 }; // namespace Utils
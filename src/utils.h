@@ -44,6 +44,11 @@ bool loadJSForDebug(const QString& jsFilePath,
 
 QString readResourceFileUtf8(const QString& resourceFilePath);
 
+/**
+ * Resident set size of this process in bytes, -1 where it can not be read.
+ */
+qint64 residentMemory();
+
 };
 
 #endif // UTILS_H
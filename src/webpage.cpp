@@ -592,6 +592,11 @@ bool WebPage::go(int historyItemRelativeIndex)
     return false;
 }
 
+void WebPage::clearHistory()
+{
+    m_customWebPage->history()->clear();
+}
+
 void WebPage::reload()
 {
     m_customWebPage->triggerAction(QWebPage::Reload);
@@ -854,6 +859,7 @@ void WebPage::finish(bool ok)
     if(ok) {
         m_finished_time = QDateTime::currentDateTime();
         m_timer->start(34);
+        emit settleStarted();
     } else {
         realLoadFinish();
     }
@@ -1365,6 +1371,21 @@ void WebPage::setWaitAfterWindowOnloadTime(int msec)
     m_waitAfterWindowOnloadTime = msec;
 }
 
+void WebPage::setAllowNetworkAccess(const bool value)
+{
+    m_networkAccessManager->setAllowNetworkAccess(value);
+}
+
+void WebPage::setRequestTag(const QVariant& tag)
+{
+    m_networkAccessManager->setRequestTag(tag);
+}
+
+QNetworkReply* WebPage::sendRequest(const QNetworkRequest& request, const QByteArray& method, const QByteArray& body)
+{
+    return m_networkAccessManager->sendRequest(request, method, body);
+}
+
 QString WebPage::windowName() const
 {
     return m_mainFrame->evaluateJavaScript("window.name;").toString();
@@ -115,6 +115,24 @@ public:
     QDateTime lastNetworkAccessTime();
     void setWaitAfterWindowOnloadTime(int msec);
 
+    /**
+     * Allow or forbid network access for this page only.
+     * Pages of a pool load concurrently, so this can not be a global switch.
+     */
+    void setAllowNetworkAccess(const bool value);
+
+    /**
+     * Tag the requests of this page with an "initiator" (emulated clicks),
+     * see NetworkAccessManager::setRequestTag.
+     */
+    void setRequestTag(const QVariant& tag);
+
+    /**
+     * Send a request with this page's network access manager and cookies,
+     * the reply is not loaded into the page.
+     */
+    QNetworkReply* sendRequest(const QNetworkRequest& request, const QByteArray& method, const QByteArray& body);
+
     /**
      * Value of <code>"window.name"</code> within the main page frame.
      *
@@ -438,6 +456,12 @@ public slots:
      * @return "true" if it does go forward/backgward in the Navigation History, "false" otherwise
      */
     bool go(int historyRelativeIndex);
+    /**
+     * Forget the Navigation History, used before a page is reused for an
+     * unrelated URL
+     * @brief clearHistory
+     */
+    void clearHistory();
     /**
      * Reload current page
      * @brief reload
@@ -468,6 +492,7 @@ signals:
     void initialized();
     void loadStarted();
     void loadFinished(const QString& status);
+    void settleStarted();
     void javaScriptAlertSent(const QString& msg);
     void javaScriptConsoleMessageSent(const QString& message);
     void javaScriptErrorSent(const QString& msg, int lineNumber, const QString& sourceID, const QString& stack);